@@ -27,6 +27,8 @@ def AUTO_LOAD():
 _LOGGER = logging.getLogger(__name__)
 
 entity_ids: dict[str] = {}
+entity_usages: dict[str, set] = {}
+entity_extra_attributes: dict[str, set] = {}
 entity_id_index = 0
 uuid_index = 0
 iconJson = None
@@ -44,6 +46,11 @@ ALARM_ARM_ACTION = nspanel_lovelace_ns.enum("alarm_arm_action", True)
 ALARM_ARM_OPTIONS = ['arm_home','arm_away','arm_night','arm_vacation','arm_custom_bypass']
 ALARM_ARM_DEFAULT_OPTIONS = ALARM_ARM_OPTIONS[:4]
 
+ENTITY_KIND = nspanel_lovelace_ns.enum("entity_kind", True)
+ENTITY_USAGE = nspanel_lovelace_ns.enum("entity_usage", True)
+HA_ATTR_TYPE = nspanel_lovelace_ns.enum("ha_attr_type", True)
+CONTROL_TYPE = nspanel_lovelace_ns.enum("control_type", True)
+
 TEMPERATURE_UNIT = nspanel_lovelace_ns.enum("temperature_unit_t", True)
 TEMPERATURE_UNIT_OPTIONS = ['celcius','fahrenheit']
 TEMPERATURE_UNIT_OPTION_MAP = {
@@ -64,6 +71,19 @@ ENTITY_TYPES = [
     'automation','script','climate','media_player','select','input_select',
     'number','input_number','text','input_text','lock','sun','person','vacuum'
 ]
+## The Home Assistant attributes which can be subscribed to (see ha_attr_type in types.h)
+HA_ATTRIBUTES = [
+    'state','device_class','supported_features','unit_of_measurement',
+    'brightness','min_mireds','max_mireds','supported_color_modes','color_mode','color_temp',
+    'rgb_color','effect_list','effect','code','code_arm_required','open_sensors',
+    'current_position','position','current_tilt_position','tilt_position',
+    'temperature','temperature_unit','forecast','duration','remaining','editable','finishes_at',
+    'current_temperature','target_temp_high','target_temp_low','target_temp_step','min_temp',
+    'max_temp','hvac_action','preset_mode','preset_modes','swing_mode','swing_modes','fan_mode',
+    'fan_modes','hvac_mode','hvac_modes','media_title','media_artist','volume_level','shuffle',
+    'media_content_type','source','source_list','options','option','min','max','value',
+    'percentage','percentage_step'
+]
 REQUIRED_TRANSLATION_KEYS = [
     "none","unknown","preset_mode","swing_mode","fan_mode","activity","away","boost",
     "comfort","eco","home","sleep","cool","cooling","dry","drying","fan","heat","heating",
@@ -117,6 +137,13 @@ CONF_ICON_VALUE = "value"
 CONF_ICON_COLOR = "color"
 CONF_ENTITY_ID = "entity_id"
 CONF_SLEEP_TIMEOUT = "sleep_timeout"
+CONF_EXTRA_ATTRIBUTES = "extra_attributes"
+CONF_DEFER_HIDDEN_UPDATES = "defer_hidden_updates"
+CONF_CONTROL_INTERVALS = "control_intervals"
+CONF_OPTIMISTIC_UPDATES = "optimistic_updates"
+CONF_STATE_SNAPSHOT = "state_snapshot"
+CONF_STATE_SNAPSHOT_SAVE_INTERVAL = "save_interval"
+CONF_RENDER_STATS = "render_stats"
 
 CONF_LOCALE = "locale"
 CONF_TEMPERATURE_UNIT = "temperature_unit"
@@ -132,6 +159,8 @@ CONF_SCREENSAVER_STATUS_ICON_RIGHT = "status_icon_right"
 CONF_SCREENSAVER_STATUS_ICON_ALT_FONT = "alt_font" # todo: to_code
 
 CONF_CARDS = "cards"
+# must match MAX_PAGES in nspanel_lovelace.h
+MAX_PAGES = 255
 CONF_CARD_TYPE = "type"
 CONF_CARD_HIDDEN = "hidden"
 CONF_CARD_TITLE = "title"
@@ -147,6 +176,14 @@ CARD_ALARM="cardAlarm"
 CARD_THERMO="cardThermo"
 CARD_MEDIA="cardMedia"
 CARD_TYPE_OPTIONS = [CARD_ENTITIES, CARD_GRID, CARD_GRID2, CARD_QR, CARD_ALARM, CARD_THERMO, CARD_MEDIA]
+## How the entities of each card are displayed, this decides which attributes are subscribed to
+CARD_ENTITY_USAGE = {
+    CARD_ENTITIES: 'row',
+    CARD_GRID: 'tile',
+    CARD_GRID2: 'tile',
+    CARD_QR: 'row',
+    CARD_MEDIA: 'tile',
+}
 
 CONF_CARD_QR_TEXT = "qr_text"
 CONF_CARD_ALARM_ENTITY_ID = "alarm_entity_id"
@@ -312,6 +349,25 @@ SCHEMA_LOCALE = cv.Schema({
     cv.Optional(CONF_LANGUAGE, default='en'): cv.string_strict,
 })
 
+SCHEMA_EXTRA_ATTRIBUTES = cv.Schema({
+    cv.Optional(entity_type): cv.All(cv.ensure_list(cv.one_of(*HA_ATTRIBUTES)), ensure_unique)
+    for entity_type in ENTITY_TYPES
+})
+
+# Keep in sync with control_type in types.h
+CONTROL_TYPES = [
+    "brightness", "color_temp", "color_wheel", "position", "tilt", "volume",
+    "temperature", "temperature_high_low", "number"
+]
+
+SCHEMA_CONTROL_INTERVALS = cv.Schema({
+    cv.Optional(control_type): cv.All(
+        cv.positive_time_period_milliseconds,
+        cv.Range(max=cv.TimePeriod(seconds=10))
+    )
+    for control_type in CONTROL_TYPES
+})
+
 SCHEMA_ICON = cv.Any(
     valid_icon_value, # icon name
     cv.Schema({
@@ -320,8 +376,11 @@ SCHEMA_ICON = cv.Any(
     })
 )
 
+SCHEMA_ENTITY_EXTRA_ATTRIBUTES = cv.All(cv.ensure_list(cv.one_of(*HA_ATTRIBUTES)), ensure_unique)
+
 SCHEMA_STATUS_ICON = cv.Schema({
     cv.Optional(CONF_ENTITY_ID): valid_entity_id(['sensor','binary_sensor','light']),
+    cv.Optional(CONF_EXTRA_ATTRIBUTES): SCHEMA_ENTITY_EXTRA_ATTRIBUTES,
     cv.Optional(CONF_ICON): SCHEMA_ICON,
     cv.Optional(CONF_SCREENSAVER_STATUS_ICON_ALT_FONT): cv.boolean,
 })
@@ -342,6 +401,7 @@ SCHEMA_CARD_ENTITY = cv.Schema({
     cv.Required(CONF_ENTITY_ID): valid_entity_id(),
     cv.Optional(CONF_CARD_ENTITIES_NAME): cv.string,
     cv.Optional(CONF_ICON): SCHEMA_ICON,
+    cv.Optional(CONF_EXTRA_ATTRIBUTES): SCHEMA_ENTITY_EXTRA_ATTRIBUTES,
 })
 
 SCHEMA_CARD_BASE = cv.Schema({
@@ -352,11 +412,28 @@ SCHEMA_CARD_BASE = cv.Schema({
     cv.Optional(CONF_CARD_SLEEP_TIMEOUT, default=10): cv.int_range(0, 43200)
 })
 
-def add_entity_id(id: str):
+def add_entity_id(id: str, usage: str = None, extra_attributes: list[str] = []):
     global entity_ids, entity_id_index
     if (entity_ids.get(id, None) is None):
         entity_ids[id] = f"nspanel_e{entity_id_index}"
         entity_id_index += 1
+    # Collect everywhere the entity is displayed so only the attributes
+    # which are actually rendered get subscribed to
+    if usage is not None:
+        entity_usages.setdefault(id, set()).add(usage)
+    entity_extra_attributes.setdefault(id, set()).update(extra_attributes)
+
+def get_entity_usage_expr(id: str):
+    usages = entity_usages.get(id, None)
+    if not usages:
+        return ENTITY_USAGE.all
+    return cg.RawExpression(' | '.join(str(getattr(ENTITY_USAGE, u)) for u in sorted(usages)))
+
+def get_attributes_mask_expr(attrs) -> Union[cg.RawExpression, int]:
+    if not attrs:
+        return 0
+    return cg.RawExpression(' | '.join(
+        f"esphome::{nspanel_lovelace_ns}::to_mask({getattr(HA_ATTR_TYPE, attr)})" for attr in sorted(attrs)))
 
 def get_card_entities_length_limits(card_type: str, model: str = 'eu') -> list[int]:
     if (card_type == CARD_ENTITIES):
@@ -375,6 +452,9 @@ def validate_config(config):
     model = config[CONF_MODEL]
     if CONF_LANGUAGE not in config[CONF_LOCALE]:
         raise cv.Invalid("A language must be specified in locale")
+    # page indexes are stored in a uint8_t, the screensaver is a page too
+    if len(config.get(CONF_CARDS, [])) + 1 > MAX_PAGES:
+        raise cv.Invalid(f"There can be at most {MAX_PAGES - 1} cards", [CONF_CARDS])
     # Build a list of custom card ids
     card_ids = []
     for card_config in config.get(CONF_CARDS, []):
@@ -406,22 +486,26 @@ def validate_config(config):
             # Add all valid HA entities to global entity list for later processing
             # if not (entity_id.startswith('iText') or entity_id.startswith('delete')):
             if not entity_id.startswith('delete'):
-                add_entity_id(entity_id)
+                add_entity_id(entity_id,
+                    CARD_ENTITY_USAGE.get(card_config[CONF_CARD_TYPE], None),
+                    entity_config.get(CONF_EXTRA_ATTRIBUTES, []))
         if CONF_CARD_ALARM_ENTITY_ID in card_config:
-            add_entity_id(card_config.get(CONF_CARD_ALARM_ENTITY_ID))
+            add_entity_id(card_config.get(CONF_CARD_ALARM_ENTITY_ID), 'card')
         if CONF_CARD_THERMO_ENTITY_ID in card_config:
-            add_entity_id(card_config.get(CONF_CARD_THERMO_ENTITY_ID))
+            add_entity_id(card_config.get(CONF_CARD_THERMO_ENTITY_ID), 'card')
         if CONF_CARD_MEDIA_ENTITY_ID in card_config:
-            add_entity_id(card_config.get(CONF_CARD_MEDIA_ENTITY_ID))
+            add_entity_id(card_config.get(CONF_CARD_MEDIA_ENTITY_ID), 'card')
 
     if CONF_SCREENSAVER in config:
         screensaver_config = config.get(CONF_SCREENSAVER)
         left = screensaver_config.get(CONF_SCREENSAVER_STATUS_ICON_LEFT, None)
         right = screensaver_config.get(CONF_SCREENSAVER_STATUS_ICON_RIGHT, None)
         if left and CONF_ENTITY_ID in left:
-            add_entity_id(left.get(CONF_ENTITY_ID))
+            add_entity_id(left.get(CONF_ENTITY_ID), 'status_icon',
+                left.get(CONF_EXTRA_ATTRIBUTES, []))
         if right and CONF_ENTITY_ID in right:
-            add_entity_id(right.get(CONF_ENTITY_ID))
+            add_entity_id(right.get(CONF_ENTITY_ID), 'status_icon',
+                right.get(CONF_EXTRA_ATTRIBUTES, []))
 
     return config
 
@@ -431,6 +515,17 @@ CONFIG_SCHEMA = cv.All(
         cv.Optional(CONF_SLEEP_TIMEOUT, default=10): cv.int_range(0, 43200),
         cv.Optional(CONF_MODEL, default='eu'): cv.one_of('eu', 'us-l', 'us-p'),
         cv.Optional(CONF_LOCALE, default={}): SCHEMA_LOCALE,
+        cv.Optional(CONF_EXTRA_ATTRIBUTES): SCHEMA_EXTRA_ATTRIBUTES,
+        cv.Optional(CONF_DEFER_HIDDEN_UPDATES, default=False): cv.boolean,
+        cv.Optional(CONF_CONTROL_INTERVALS, default={}): SCHEMA_CONTROL_INTERVALS,
+        cv.Optional(CONF_OPTIMISTIC_UPDATES, default=True): cv.boolean,
+        cv.Optional(CONF_STATE_SNAPSHOT): cv.Schema({
+            cv.Optional(CONF_STATE_SNAPSHOT_SAVE_INTERVAL, default="10min"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(minutes=1))
+            ),
+        }),
+        cv.Optional(CONF_RENDER_STATS, default=False): cv.boolean,
         cv.Optional(CONF_SCREENSAVER, default={}): SCHEMA_SCREENSAVER,
         cv.Optional(CONF_INCOMING_MSG): automation.validate_automation(
             cv.Schema({
@@ -646,6 +741,33 @@ async def to_code(config):
     if CONF_SLEEP_TIMEOUT in config:
         cg.add(nspanel.set_display_timeout(config[CONF_SLEEP_TIMEOUT]))
 
+    if config[CONF_DEFER_HIDDEN_UPDATES]:
+        cg.add(nspanel.set_defer_hidden_updates(True))
+
+    for control_type, interval in config[CONF_CONTROL_INTERVALS].items():
+        cg.add(nspanel.set_control_interval(getattr(CONTROL_TYPE, control_type), interval))
+
+    if not config[CONF_OPTIMISTIC_UPDATES]:
+        cg.add(nspanel.set_optimistic_updates(False))
+
+    # Extends the built in ENTITY_SUBSCRIPTIONS table in types.h
+    extra_subscriptions = []
+    for entity_type, attrs in config.get(CONF_EXTRA_ATTRIBUTES, {}).items():
+        if len(attrs) == 0:
+            continue
+        kind = getattr(ENTITY_KIND, entity_type + '_' if entity_type == 'switch' else entity_type)
+        extra_subscriptions.append(f"{{{kind}, {ENTITY_USAGE.all}, {get_attributes_mask_expr(attrs)}}}")
+    if len(extra_subscriptions) > 0:
+        cg.add_define("NSPANEL_EXTRA_SUBSCRIPTIONS", cg.RawExpression(', '.join(extra_subscriptions)))
+
+    if CONF_STATE_SNAPSHOT in config:
+        cg.add_define("USE_NSPANEL_STATE_SNAPSHOT")
+        cg.add(nspanel.set_state_snapshot_interval(
+            config[CONF_STATE_SNAPSHOT][CONF_STATE_SNAPSHOT_SAVE_INTERVAL]))
+
+    if config[CONF_RENDER_STATS]:
+        cg.add_define("USE_NSPANEL_RENDER_STATS")
+
     locale_config = config[CONF_LOCALE]
     global translationJson
     load_translations(locale_config[CONF_LANGUAGE])
@@ -676,7 +798,8 @@ async def to_code(config):
         await automation.build_automation(trigger, [(cg.std_string, "x")], conf)
 
     for key, value in entity_ids.items():
-        cg.add(cg.RawExpression(f"auto {value} = {nspanel.create_entity(key)}"))
+        cg.add(cg.RawExpression(f"auto {value} = " + str(nspanel.create_entity(
+            key, get_entity_usage_expr(key), get_attributes_mask_expr(entity_extra_attributes.get(key, None))))))
 
     screensaver_config = config.get(CONF_SCREENSAVER, None)
     screensaver_uuid = None
@@ -28,7 +28,16 @@ Card::Card(
 
 void Card::accept(PageVisitor& visitor) { visitor.visit(*this); }
 
-std::string &Card::render(std::string &buffer) {
+void Card::on_item_render_invalid(const PageItem *item) {
+  // the navigation isn't tracked as an item span
+  if (item == this->nav_left.get() || item == this->nav_right.get()) {
+    this->render_invalid_ = true;
+    return;
+  }
+  Page::on_item_render_invalid(item);
+}
+
+std::string &Card::render_(std::string &buffer) {
   buffer.assign(this->get_render_instruction())
       .append(1, SEPARATOR)
       .append(this->get_title())
@@ -36,11 +45,7 @@ std::string &Card::render(std::string &buffer) {
   
   this->render_nav(buffer);
 
-  for (auto& item : this->items_) {
-    buffer.append(1, SEPARATOR).append(item->render());
-  }
-
-  return buffer;
+  return this->render_items_(buffer);
 }
 
 std::string &Card::render_nav(std::string &buffer) {
@@ -73,19 +78,13 @@ void CardItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
 std::string &CardItem::render_(std::string &buffer) {
   StatefulPageItem::render_(buffer);
-  if (this->entity_->is_type(entity_type::delete_))
+  if (this->entity_->is_type(entity_kind::delete_))
     buffer.append(1, SEPARATOR);
   else
     // displayName~
     PageItem_DisplayName::render_(buffer).append(1, SEPARATOR);
   return buffer;
 }
-  
-uint16_t CardItem::get_render_buffer_reserve_() const {
-  // try to guess the required size of the buffer to reduce heap fragmentation
-  return StatefulPageItem::get_render_buffer_reserve_() + 
-      this->display_name_.length() + 1;
-}
 
 } // namespace nspanel_lovelace
 } // namespace esphome
\ No newline at end of file
@@ -29,18 +29,23 @@ public:
 
   void set_nav_left(std::unique_ptr<NavigationItem> &nav) {
     this->nav_left.swap(nav);
+    if (this->nav_left) this->nav_left->set_page(this);
+    this->render_invalid_ = true;
   }
   void set_nav_right(std::unique_ptr<NavigationItem> &nav) {
     this->nav_right.swap(nav);
+    if (this->nav_right) this->nav_right->set_page(this);
+    this->render_invalid_ = true;
   }
 
-  std::string &render(std::string &buffer) override;
+  void on_item_render_invalid(const PageItem *item) override;
 
 protected:
   std::unique_ptr<NavigationItem> nav_left;
   std::unique_ptr<NavigationItem> nav_right;
 
   const char *get_render_instruction() const override { return "entityUpd"; }
+  std::string &render_(std::string &buffer) override;
   std::string &render_nav(std::string &buffer);
 };
 
@@ -62,7 +67,6 @@ public:
 protected:
   // output: type~internalName~icon~iconColor~displayName~
   std::string &render_(std::string &buffer) override;
-  uint16_t get_render_buffer_reserve_() const override;
 };
 
 } // namespace nspanel_lovelace
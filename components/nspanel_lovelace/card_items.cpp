@@ -17,16 +17,12 @@ namespace nspanel_lovelace {
 
 GridCardEntityItem::GridCardEntityItem(
     const std::string &uuid, std::shared_ptr<Entity> entity) : 
-    CardItem(uuid, std::move(entity)) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    CardItem(uuid, std::move(entity)) {}
 
 GridCardEntityItem::GridCardEntityItem(
     const std::string &uuid, std::shared_ptr<Entity> entity, 
     const std::string &display_name) : 
-    CardItem(uuid, std::move(entity), display_name) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    CardItem(uuid, std::move(entity), display_name) {}
 
 void GridCardEntityItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
@@ -39,7 +35,6 @@ EntitiesCardEntityItem::EntitiesCardEntityItem(
     CardItem(uuid, std::move(entity)), PageItem_Value(this) {
   // todo: fix this - needs to be called to ensure overloaded set_on_state_callback_ is called
   this->on_entity_type_change(this->get_type());
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
 }
 
 EntitiesCardEntityItem::EntitiesCardEntityItem(
@@ -49,59 +44,59 @@ EntitiesCardEntityItem::EntitiesCardEntityItem(
     PageItem_Value(this) {
   // todo: fix this - needs to be called to ensure overloaded set_on_state_callback_ is called
   this->on_entity_type_change(this->get_type());
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
 }
 
 void EntitiesCardEntityItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
-void EntitiesCardEntityItem::on_entity_attribute_change(
-    ha_attr_type attr, const std::string &value) {
-  StatefulPageItem::on_entity_attribute_change(attr, value);
-
-  if (attr == ha_attr_type::unit_of_measurement) {
-    this->set_value_postfix(value);
-    return;
+void EntitiesCardEntityItem::on_entity_changed(ha_attr_mask changed) {
+  if (changed & to_mask(ha_attr_type::unit_of_measurement)) {
+    this->set_value_postfix(
+      this->get_attribute(ha_attr_type::unit_of_measurement));
   }
 
   // Sometimes attribute changes also require updating the state for certain
-  // entity types seen below
-  if (!this->on_state_callback_) return;
-
-  if (this->is_type(entity_type::cover)) {
-    if (attr == ha_attr_type::current_position) {
+  // entity types seen below, these are handled like a state change
+  ha_attr_mask state_attrs = 0;
+  switch(this->get_type()) {
+    case entity_kind::cover: {
       // this is a cheat/shortcut to avoid state change spamming
-      if (!value.empty() && value != "100" && value != "0") {
-        return;
+      auto &position = this->get_attribute(ha_attr_type::current_position);
+      if (position.empty() || position == "100" || position == "0") {
+        state_attrs = to_mask(ha_attr_type::current_position);
       }
+      break;
     }
-  } else if (this->is_type(entity_type::climate)) {
-    // Only these two attributes affect the visual output
-    // so avoid the state callback for anything else
-    if (attr != ha_attr_type::temperature &&
-        attr != ha_attr_type::current_temperature) {
-      return;
-    }
-  } else if (
-      this->is_type(entity_type::number) ||
-      this->is_type(entity_type::input_number)) {
-    if (attr != ha_attr_type::min &&
-        attr != ha_attr_type::max) {
-      return;
-    }
-  } else if (this->is_type(entity_type::weather)) {
-    if (attr != ha_attr_type::temperature &&
-        attr != ha_attr_type::temperature_unit) {
-      return;
-    }
-  } else if (this->is_type(entity_type::media_player)) {
-    // All attribute updates effect render output for this entity
-  } else {
-    // Any entity type not mentioned above doesn't need re-rendering
-    return;
+    case entity_kind::climate:
+      // Only these two attributes affect the visual output
+      // so avoid the state callback for anything else
+      state_attrs =
+        to_mask(ha_attr_type::temperature) |
+        to_mask(ha_attr_type::current_temperature);
+      break;
+    case entity_kind::number:
+    case entity_kind::input_number:
+      state_attrs =
+        to_mask(ha_attr_type::min) |
+        to_mask(ha_attr_type::max);
+      break;
+    case entity_kind::weather:
+      state_attrs =
+        to_mask(ha_attr_type::temperature) |
+        to_mask(ha_attr_type::temperature_unit);
+      break;
+    case entity_kind::media_player:
+      // All attribute updates effect render output for this entity
+      state_attrs = ~static_cast<ha_attr_mask>(0);
+      break;
+    default:
+      // Any entity type not mentioned above doesn't need re-rendering
+      break;
+  }
+  if (changed & state_attrs) {
+    changed |= to_mask(ha_attr_type::state);
   }
 
-  this->on_state_callback_(this);
-  this->set_render_invalid();
+  StatefulPageItem::on_entity_changed(changed);
 }
 
 void EntitiesCardEntityItem::state_generic_fn(StatefulPageItem *me) {
@@ -271,7 +266,7 @@ void EntitiesCardEntityItem::state_translate_fn(StatefulPageItem *me) {
   // Firstly try to find a match for a specific entity type, then
   // find a match for the generic state, otherwise use the raw state value
   const char *ret;
-  std::string key = me->get_type();
+  std::string key = me->get_type_str();
   key.append(1, '.').append(me_->get_state());
   if (!try_get_value(TRANSLATION_MAP, ret, key)) {
     if (!try_get_value(TRANSLATION_MAP, ret, me_->get_state())) {
@@ -282,50 +277,62 @@ void EntitiesCardEntityItem::state_translate_fn(StatefulPageItem *me) {
   me_->value_ = ret;
 }
 
-void EntitiesCardEntityItem::set_on_state_callback_(const char *type) {
-  if (type == entity_type::light ||
-      type == entity_type::switch_ ||
-      type == entity_type::input_boolean ||
-      type == entity_type::automation ||
-      type == entity_type::fan) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_on_off_fn;
-  } else if (
-      type == entity_type::button ||
-      type == entity_type::input_button ||
-      type == entity_type::navigate) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_button_fn;
-  } else if (type == entity_type::scene) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_scene_fn;
-  } else if (
-      type == entity_type::script ||
-      type == entity_type::service) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_script_fn;
-  } else if (type == entity_type::timer) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_timer_fn;
-  } else if (type == entity_type::cover) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_cover_fn;
-  } else if (type == entity_type::climate) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_climate_fn;
-  } else if (
-      type == entity_type::number ||
-      type == entity_type::input_number) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_number_fn;
-  } else if (type == entity_type::lock) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_lock_fn;
-  } else if (type == entity_type::weather) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_weather_fn;
-  } else if (type == entity_type::sun) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_sun_fn;
-  } else if (type == entity_type::vacuum) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_vacuum_fn;
-  } else if (
-      type == entity_type::person ||
-      type == entity_type::alarm_control_panel ||
-      type == entity_type::binary_sensor) {
-    this->on_state_callback_ = EntitiesCardEntityItem::state_translate_fn;
-  } else {
+constexpr EntitiesCardEntityItem::state_callback_t
+    EntitiesCardEntityItem::select_state_callback_(entity_kind kind) {
+  switch(kind) {
+    case entity_kind::light:
+    case entity_kind::switch_:
+    case entity_kind::input_boolean:
+    case entity_kind::automation:
+    case entity_kind::fan:
+      return EntitiesCardEntityItem::state_on_off_fn;
+    case entity_kind::button:
+    case entity_kind::input_button:
+    case entity_kind::navigate:
+      return EntitiesCardEntityItem::state_button_fn;
+    case entity_kind::scene:
+      return EntitiesCardEntityItem::state_scene_fn;
+    case entity_kind::script:
+    case entity_kind::service:
+      return EntitiesCardEntityItem::state_script_fn;
+    case entity_kind::timer:
+      return EntitiesCardEntityItem::state_timer_fn;
+    case entity_kind::cover:
+      return EntitiesCardEntityItem::state_cover_fn;
+    case entity_kind::climate:
+      return EntitiesCardEntityItem::state_climate_fn;
+    case entity_kind::number:
+    case entity_kind::input_number:
+      return EntitiesCardEntityItem::state_number_fn;
+    case entity_kind::lock:
+      return EntitiesCardEntityItem::state_lock_fn;
+    case entity_kind::weather:
+      return EntitiesCardEntityItem::state_weather_fn;
+    case entity_kind::sun:
+      return EntitiesCardEntityItem::state_sun_fn;
+    case entity_kind::vacuum:
+      return EntitiesCardEntityItem::state_vacuum_fn;
+    case entity_kind::person:
+    case entity_kind::alarm_control_panel:
+    case entity_kind::binary_sensor:
+      return EntitiesCardEntityItem::state_translate_fn;
+    default:
+      return EntitiesCardEntityItem::state_generic_fn;
+  }
+}
+
+// built at compile time, kinds without a callback map to state_generic_fn
+const std::array<EntitiesCardEntityItem::state_callback_t, ENTITY_KIND_COUNT>
+    EntitiesCardEntityItem::state_callbacks_ = make_entity_kind_table(
+      EntitiesCardEntityItem::select_state_callback_);
+
+void EntitiesCardEntityItem::set_on_state_callback_(entity_kind kind) {
+  if (static_cast<size_t>(kind) >= ENTITY_KIND_COUNT) {
     this->on_state_callback_ = EntitiesCardEntityItem::state_generic_fn;
+    return;
   }
+  this->on_state_callback_ =
+    EntitiesCardEntityItem::state_callbacks_[static_cast<size_t>(kind)];
 }
 
 std::string &EntitiesCardEntityItem::render_(std::string &buffer) {
@@ -333,11 +340,5 @@ std::string &EntitiesCardEntityItem::render_(std::string &buffer) {
   return PageItem_Value::render_(buffer);
 }
 
-uint16_t EntitiesCardEntityItem::get_render_buffer_reserve_() const {
-  // try to guess the required size of the buffer to reduce heap fragmentation
-  return CardItem::get_render_buffer_reserve_() +
-         this->value_.length() + this->value_postfix_.length() + 2;
-}
-
 } // namespace nspanel_lovelace
 } // namespace esphome
\ No newline at end of file
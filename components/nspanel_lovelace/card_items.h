@@ -3,6 +3,7 @@
 #include "card_base.h"
 #include "entity.h"
 #include "page_item_visitor.h"
+#include <array>
 #include <memory>
 #include <stdint.h>
 #include <string>
@@ -41,7 +42,7 @@ public:
 
   void accept(PageItemVisitor& visitor) override;
   
-  void on_entity_attribute_change(ha_attr_type attr, const std::string &value) override;
+  void on_entity_changed(ha_attr_mask changed) override;
 
   const std::string &get_value() const { return this->value_; }
 
@@ -61,11 +62,12 @@ protected:
   static void state_vacuum_fn(StatefulPageItem *me);
   static void state_translate_fn(StatefulPageItem *me);
 
-  void set_on_state_callback_(const char *type) override;
+  void set_on_state_callback_(entity_kind kind) override;
+  static constexpr state_callback_t select_state_callback_(entity_kind kind);
+  static const std::array<state_callback_t, ENTITY_KIND_COUNT> state_callbacks_;
 
   // output: type~internalName~icon~iconColor~displayName~value
   std::string &render_(std::string &buffer) override;
-  uint16_t get_render_buffer_reserve_() const override;
 };
 
 } // namespace nspanel_lovelace
@@ -31,7 +31,7 @@ void EntitiesCard::accept(PageVisitor& visitor) { visitor.visit(*this); }
 
 void QRCard::accept(PageVisitor& visitor) { visitor.visit(*this); }
 
-std::string &QRCard::render(std::string &buffer) {
+std::string &QRCard::render_(std::string &buffer) {
   buffer.assign(this->get_render_instruction())
       .append(1, SEPARATOR)
       .append(this->get_title())
@@ -41,9 +41,7 @@ std::string &QRCard::render(std::string &buffer) {
 
   buffer.append(this->qr_text_);
 
-  for (auto& item : this->items_) {
-    buffer.append(1, SEPARATOR).append(item->render());
-  }
+  this->render_items_(buffer);
 
   return buffer;
 }
@@ -135,7 +133,16 @@ bool AlarmCard::add_arm_button(alarm_arm_action action) {
   return true;
 }
 
-void AlarmCard::on_entity_state_change(const std::string &state) {
+void AlarmCard::on_entity_changed(ha_attr_mask changed) {
+  this->render_invalid_ = true;
+  if (changed & to_mask(ha_attr_type::code_arm_required)) {
+    this->set_show_keypad(this->alarm_entity_->get_attribute(
+      ha_attr_type::code_arm_required) != entity_state::off);
+  }
+
+  if ((changed & to_mask(ha_attr_type::state)) == 0) return;
+
+  auto &state = this->alarm_entity_->get_state();
   this->status_icon_flashing_ = false;
 
   if (state == entity_state::triggered || 
@@ -151,13 +158,7 @@ void AlarmCard::on_entity_state_change(const std::string &state) {
   this->status_icon_->set_icon_value(icon.value);
 }
 
-void AlarmCard::on_entity_attribute_change(ha_attr_type attr, const std::string &value) {
-  if (attr == ha_attr_type::code_arm_required) {
-    this->set_show_keypad(value != entity_state::off);
-  }
-}
-
-std::string &AlarmCard::render(std::string &buffer) {
+std::string &AlarmCard::render_(std::string &buffer) {
   buffer.assign(this->get_render_instruction())
       .append(1, SEPARATOR)
       .append(this->get_title())
@@ -244,7 +245,7 @@ void ThermoCard::configure_temperature_unit() {
   }
 }
 
-std::string &ThermoCard::render(std::string &buffer) {
+std::string &ThermoCard::render_(std::string &buffer) {
   buffer.assign(this->get_render_instruction())
       .append(1, SEPARATOR)
       .append(this->get_title())
@@ -272,14 +273,13 @@ std::string &ThermoCard::render(std::string &buffer) {
     dest_temp2_str = this->thermo_entity_->get_attribute(
       ha_attr_type::target_temp_low);
     if (!dest_temp2_str.empty()) {
-      dest_temp2_str = std::to_string(
-        static_cast<int>(std::stof(dest_temp2_str) * 10));
+      dest_temp2_str.assign(num_str(
+        static_cast<int32_t>(std::stof(dest_temp2_str) * 10)));
     }
   }
-  dest_temp_str = std::to_string(
-    static_cast<int>(std::stof(dest_temp_str) * 10));
-
-  buffer.append(dest_temp_str).append(1, SEPARATOR);
+  buffer.append(num_str(
+    static_cast<int32_t>(std::stof(dest_temp_str) * 10)));
+  buffer.append(1, SEPARATOR);
 
   auto hvac_action = this->thermo_entity_->get_attribute(
     ha_attr_type::hvac_action);
@@ -296,17 +296,17 @@ std::string &ThermoCard::render(std::string &buffer) {
   }
   buffer.append(1, SEPARATOR);
 
-  buffer.append(std::to_string(static_cast<int>(
+  buffer.append(num_str(static_cast<int32_t>(
     std::stof(this->thermo_entity_->get_attribute(
       ha_attr_type::min_temp, "0")) * 10)));
   buffer.append(1, SEPARATOR);
 
-  buffer.append(std::to_string(static_cast<int>(
+  buffer.append(num_str(static_cast<int32_t>(
     std::stof(this->thermo_entity_->get_attribute(
       ha_attr_type::max_temp, "0")) * 10)));
   buffer.append(1, SEPARATOR);
 
-  buffer.append(std::to_string(static_cast<int>(
+  buffer.append(num_str(static_cast<int32_t>(
     std::stof(this->thermo_entity_->get_attribute(
       ha_attr_type::target_temp_step, "0.5")) * 10)));
   
@@ -321,21 +321,21 @@ std::string &ThermoCard::render(std::string &buffer) {
     split_str(',', hvac_modes_str, hvac_modes);
 
     for (auto& mode : hvac_modes) {
-      uint16_t active_colour = 64512U; //dark orange
+      const char *active_colour = ui_color::dark_orange;
       if (mode == entity_state::auto_ ||
           mode == entity_state::heat_cool) {
-        active_colour = 1024U; //dark green
+        active_colour = ui_color::dark_green;
       } else if (mode == entity_state::off ||
           mode == entity_state::fan_only) {
-        active_colour = 52857U; // light grey (was: muddy grey|35921)
+        active_colour = ui_color::light_grey; // (was: muddy grey|35921)
       } else if (mode == entity_state::cool) {
-        active_colour = 11487U; //light blue
+        active_colour = ui_color::cool_blue;
       } else if (mode == entity_state::dry) {
-        active_colour = 60897U; //light orange
+        active_colour = ui_color::light_orange;
       }
       buffer.append(1, SEPARATOR);
       buffer.append(CHAR8_CAST(get_icon(CLIMATE_ICON_MAP, mode))).append(1, SEPARATOR);
-      buffer.append(std::to_string(active_colour)).append(1, SEPARATOR);
+      buffer.append(active_colour).append(1, SEPARATOR);
       buffer.append(1, this->thermo_entity_->is_state(mode) ? '1' : '0');
       buffer.append(1, SEPARATOR);
       buffer.append(mode);
@@ -399,7 +399,7 @@ MediaCard::~MediaCard() {
 void MediaCard::accept(PageVisitor& visitor) { visitor.visit(*this); }
 
 // entityUpd~{heading}~{navigation}~{entityId}~{title}~~{author}~~{volume}~{iconplaypause}~{onoffbutton}~{shuffleBtn}{media_icon}{item_str}
-std::string &MediaCard::render(std::string &buffer) {
+std::string &MediaCard::render_(std::string &buffer) {
   buffer.assign(this->get_render_instruction())
       .append(1, SEPARATOR)
       .append(this->get_title())
@@ -418,7 +418,7 @@ std::string &MediaCard::render(std::string &buffer) {
     ha_attr_type::media_artist).substr(0, 40));
   buffer.append(2, SEPARATOR);
 
-  buffer.append(std::to_string(
+  buffer.append(num_str(
     static_cast<uint8_t>(std::stof(this->media_entity_->get_attribute(
       ha_attr_type::volume_level, "0")) * 100.0f)));
   buffer.append(1, SEPARATOR);
@@ -433,9 +433,9 @@ std::string &MediaCard::render(std::string &buffer) {
   // on/off button colour
   if (supported_features & 0b10000000) {
     if (this->media_entity_->is_state(entity_state::off))
-      buffer.append(std::to_string(1374)); // light blue
+      buffer.append(ui_color::light_blue);
     else
-      buffer.append(std::to_string(64704)); // orange
+      buffer.append(ui_color::orange);
   } else {
     buffer.append(generic_type::disable);
   }
@@ -462,11 +462,9 @@ std::string &MediaCard::render(std::string &buffer) {
     this->media_entity_->get_attribute(ha_attr_type::media_content_type),
     icon_t::speaker_off);
   buffer.append(CHAR8_CAST(media_icon)).append(1, SEPARATOR);
-  buffer.append(std::to_string(17299U)).append(2, SEPARATOR);
+  buffer.append(ui_color::ha_blue).append(2, SEPARATOR);
   
-  for (auto& item : this->items_) {
-    buffer.append(1, SEPARATOR).append(item->render());
-  }
+  this->render_items_(buffer);
   if (this->items_.size() > 0) buffer.append(1, SEPARATOR);
 
   return buffer;
@@ -66,11 +66,14 @@ public:
   void accept(PageVisitor& visitor) override;
 
   const std::string &get_qr_text() const { return this->qr_text_; }
-  void set_qr_text(const std::string &qr_text) { this->qr_text_ = qr_text; }
-
-  std::string &render(std::string &buffer) override;
+  void set_qr_text(const std::string &qr_text) {
+    this->qr_text_ = qr_text;
+    this->render_invalid_ = true;
+  }
 
 protected:
+  std::string &render_(std::string &buffer) override;
+
   std::string qr_text_;
 };
 
@@ -92,15 +95,22 @@ public:
 
   void accept(PageVisitor& visitor) override;
 
-  void set_show_keypad(bool show_keypad) { this->show_keypad_ = show_keypad; }
+  void set_show_keypad(bool show_keypad) {
+    this->show_keypad_ = show_keypad;
+    this->render_invalid_ = true;
+  }
   bool add_arm_button(alarm_arm_action action);
+  Entity *get_alarm_entity() const { return this->alarm_entity_.get(); }
 
-  void on_entity_state_change(const std::string &state) override;
-  void on_entity_attribute_change(ha_attr_type attr, const std::string &value) override;
-
-  std::string &render(std::string &buffer) override;
+  void on_entity_changed(ha_attr_mask changed) override;
+  // the buttons depend on the alarm state so the page is always rebuilt
+  void on_item_render_invalid(const PageItem *item) override {
+    this->render_invalid_ = true;
+  }
 
 protected:
+  std::string &render_(std::string &buffer) override;
+
   std::shared_ptr<Entity> alarm_entity_;
   bool show_keypad_, status_icon_flashing_;
   std::unique_ptr<AlarmButtonItem> disarm_button_;
@@ -128,10 +138,15 @@ public:
   void accept(PageVisitor& visitor) override;
 
   void configure_temperature_unit();
+  Entity *get_thermo_entity() const { return this->thermo_entity_.get(); }
 
-  std::string &render(std::string &buffer) override;
+  void on_entity_changed(ha_attr_mask changed) override {
+    this->render_invalid_ = true;
+  }
 
 protected:
+  std::string &render_(std::string &buffer) override;
+
   std::shared_ptr<Entity> thermo_entity_;
   const icon_char_t* temperature_unit_icon_;
 };
@@ -155,9 +170,15 @@ public:
 
   void accept(PageVisitor& visitor) override;
 
-  std::string &render(std::string &buffer) override;
+  Entity *get_media_entity() const { return this->media_entity_.get(); }
+
+  void on_entity_changed(ha_attr_mask changed) override {
+    this->render_invalid_ = true;
+  }
 
 protected:
+  std::string &render_(std::string &buffer) override;
+
   std::shared_ptr<Entity> media_entity_;
 };
 
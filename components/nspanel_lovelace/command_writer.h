@@ -0,0 +1,92 @@
+#pragma once
+
+#include "config.h"
+#include "defines.h"
+#include "helpers.h"
+#include "types.h"
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace esphome {
+namespace nspanel_lovelace {
+
+// Writes a '~' separated command straight into the command buffer.
+// Every field() starts a new field and append() adds to the current one, e.g.
+//   command_writer(buffer, "entityUpdateDetail").uuid(uuid).field().flag(true)
+// writes "entityUpdateDetail~uuid.{uuid}~~enable".
+class command_writer {
+public:
+  command_writer(std::string &buffer, const char *command) : buffer_(buffer) {
+    this->buffer_.assign(command);
+  }
+
+  // Starts a new, empty field
+  command_writer &field() {
+    this->buffer_.append(1, SEPARATOR);
+    return *this;
+  }
+  template<class T>
+  command_writer &field(const T &value) {
+    return this->field().append(value);
+  }
+
+  command_writer &append(const char *value) {
+    this->buffer_.append(value_or_empty(value));
+    return *this;
+  }
+  command_writer &append(std::string_view value) {
+    this->buffer_.append(value);
+    return *this;
+  }
+#if defined(__cpp_char8_t)
+  command_writer &append(const icon_char_t *value) {
+    return this->append(CHAR8_CAST(value));
+  }
+#endif
+  // any integer type, a single overload can't be ambiguous whatever
+  // int32_t is on the toolchain, characters go through append_char()
+  template<class T, typename std::enable_if<is_integer_number_v<T>, int>::type = 0>
+  command_writer &append(const T value) {
+    return this->append(num_str(value));
+  }
+  command_writer &append_char(const char value) {
+    this->buffer_.append(1, value);
+    return *this;
+  }
+
+  // uuid.{uuid}
+  command_writer &uuid(const std::string &uuid) {
+    return this->field("uuid.").append(uuid);
+  }
+  // 'enable' or 'disable'
+  command_writer &flag(const bool enabled) {
+    return this->field(enabled ? generic_type::enable : generic_type::disable);
+  }
+  // '1' or '0'
+  command_writer &bit(const bool set) {
+    return this->field().append_char(set ? '1' : '0');
+  }
+  // {value}% when present, otherwise 'disable'
+  command_writer &percent_or_disable(const bool present, const int32_t value) {
+    if (!present) return this->field(generic_type::disable);
+    return this->field(value).append_char('%');
+  }
+  // Appends a list with its delimiter replaced by the '?' the display
+  // expects, e.g. "a,b,c" becomes "a?b?c"
+  command_writer &list(const std::string &values, const char delimiter = ',') {
+    size_t start = this->buffer_.length();
+    this->buffer_.append(values);
+    for (size_t i = start; i < this->buffer_.length(); i++) {
+      if (this->buffer_[i] == delimiter) this->buffer_[i] = '?';
+    }
+    return *this;
+  }
+
+protected:
+  std::string &buffer_;
+};
+
+} // namespace nspanel_lovelace
+} // namespace esphome
@@ -16,8 +16,27 @@ constexpr char SEPARATOR = '~';
 // workaround for https://github.com/sairon/esphome-nspanel-lovelace-ui/issues/8
 constexpr uint8_t COMMAND_COOLDOWN = 75u;
 constexpr uint16_t DEFAULT_SLEEP_TIMEOUT_S = 20u;
+// Entity changes are collected for this long before subscribers are notified,
+// each update extends the delay up to ENTITY_FLUSH_MAX_DELAY
+constexpr uint16_t ENTITY_FLUSH_DELAY = 200u;
+constexpr uint16_t ENTITY_FLUSH_MAX_DELAY = 1000u;
+// Default minimum time between service calls sent for a single slider
+constexpr uint16_t CONTROL_MIN_INTERVAL = 200u;
+// Optimistic updates which Home Assistant hasn't confirmed within this time are reverted
+constexpr uint16_t OPTIMISTIC_UPDATE_TIMEOUT = 3000u;
+// Buffers of sent commands kept for queuing new ones, larger buffers
+// are freed so a burst of big pages doesn't hold on to the memory
+constexpr uint8_t COMMAND_POOL_SIZE = 4u;
+constexpr uint16_t COMMAND_POOL_MAX_CAPACITY = 1024u;
+// Reserved entries for service call data, the largest call sends three
+constexpr uint8_t HA_SERVICE_MAX_DATA = 4u;
 // Change this value when the state object structure changes
 constexpr uint32_t RESTORE_STATE_VERSION = 0xA62E0210;
+// Change this value when the state snapshot structure changes
+constexpr uint32_t STATE_SNAPSHOT_VERSION = 0xA62E0311;
+constexpr uint16_t STATE_SNAPSHOT_SIZE = 1024u;
+// Longer values (mostly option lists) are not worth the flash space
+constexpr uint8_t STATE_SNAPSHOT_MAX_VALUE_LENGTH = 48u;
 
 class Configuration {
 public:
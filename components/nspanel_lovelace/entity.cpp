@@ -9,10 +9,10 @@ Entity::Entity(const std::string &entity_id) :
   this->set_entity_id(entity_id);
   enable_notifications_ = true;
 }
-Entity::Entity(const std::string &entity_id, const char *type) : 
-    type_(type), type_overridden_(true),
+Entity::Entity(const std::string &entity_id, entity_kind kind) : 
+    kind_(kind), type_overridden_(true),
     state_(entity_state::unknown) {
-  assert(!entity_id.empty() && type != nullptr);
+  assert(!entity_id.empty() && kind != entity_kind::unknown);
   this->set_entity_id(entity_id);
   enable_notifications_ = true;
 }
@@ -47,13 +47,13 @@ void Entity::set_entity_id(const std::string &entity_id) {
   if (!this->type_overridden_) {
     if (!this->set_type(get_entity_type(this->entity_id_))) {
       // todo: should we be setting a fallback type?
-      this->type_ = entity_type::text;
+      this->kind_ = entity_kind::text;
     }
   }
 
   // extract the text from iText entities
   // todo: remove this after creating a StaticTextItem
-  if (this->is_type(entity_type::itext)) {
+  if (this->is_type(entity_kind::itext)) {
     auto pos = this->entity_id_.rfind('.', strlen(entity_type::itext) + 1);
     if (pos != std::string::npos && pos < this->entity_id_.length()) {
       this->set_state(this->entity_id_.substr(pos + 1));
@@ -61,23 +61,15 @@ void Entity::set_entity_id(const std::string &entity_id) {
   }
 }
 
-const char *Entity::get_type() const { return this->type_; }
-
-bool Entity::is_type(const char *type) const {
-  if (type == nullptr || this->type_ == nullptr) return false;
-  if (type == this->type_) return true;
-  return std::strcmp(this->type_, type) == 0;
-}
-
-bool Entity::set_type(const char *type) {
-  if (type == nullptr || type[0] == '\0') {
+bool Entity::set_type(entity_kind kind) {
+  if (kind == entity_kind::unknown) {
     return false;
   }
-  if (this->type_ == type) return true;
-  this->type_ = type;
+  if (this->kind_ == kind) return true;
+  this->kind_ = kind;
 
   if (this->enable_notifications_) {
-    this->notify_type_change(type);
+    this->notify_type_change(kind);
   }
   return true;
 }
@@ -86,13 +78,10 @@ bool Entity::is_state(const std::string &state) const { return this->state_ == s
 
 const std::string &Entity::get_state() const { return this->state_; }
 
-void Entity::set_state(const std::string &state) {
+void Entity::set_state(std::string state) {
   if (this->state_ == state) return;
-  this->state_ = state;
-
-  if (this->enable_notifications_) {
-    this->notify_state_change(state);
-  }
+  this->state_ = std::move(state);
+  this->mark_changed(ha_attr_type::state);
 }
 
 bool Entity::has_attribute(ha_attr_type attr) const {
@@ -105,23 +94,25 @@ const std::string &Entity::get_attribute(ha_attr_type attr, const std::string &d
   return it == attributes_.end() ? default_value : it->second;
 }
 
-void Entity::set_attribute(ha_attr_type attr, const std::string &value) {
+void Entity::set_attribute(ha_attr_type attr, std::string value) {
   if (value.empty() || value == "None" || value == "none") {
-    attributes_.erase(attr);
-    this->notify_attribute_change(attr, "");
+    if (attributes_.erase(attr) > 0) {
+      this->mark_changed(attr);
+    }
     return;
   }
-  if (this->attributes_[attr] == value) return;
 
   if (attr == ha_attr_type::brightness) {
-    this->attributes_[attr] = std::to_string(static_cast<int>(round(
+    value = std::to_string(static_cast<int>(round(
         scale_value(std::stoi(value), {0, 255}, {0, 100}))));
   } else if (attr == ha_attr_type::color_temp) {
-    auto &minstr = this->get_attribute(ha_attr_type::min_mireds);
-    auto &maxstr = this->get_attribute(ha_attr_type::max_mireds);
-    uint16_t min_mireds = minstr.empty() ? 153 : std::stoi(minstr);
-    uint16_t max_mireds = maxstr.empty() ? 500 : std::stoi(maxstr);
-    this->attributes_[attr] = std::to_string(static_cast<int>(round(scale_value(
+    // get_attribute() returns its default argument when the attribute
+    // isn't stored, which is a temporary here
+    uint16_t min_mireds = this->has_attribute(ha_attr_type::min_mireds)
+      ? std::stoi(this->get_attribute(ha_attr_type::min_mireds)) : 153;
+    uint16_t max_mireds = this->has_attribute(ha_attr_type::max_mireds)
+      ? std::stoi(this->get_attribute(ha_attr_type::max_mireds)) : 500;
+    value = std::to_string(static_cast<int>(round(scale_value(
         std::stoi(value),
         {static_cast<double>(min_mireds), static_cast<double>(max_mireds)},
         {0, 100}))));
@@ -136,40 +127,61 @@ void Entity::set_attribute(ha_attr_type attr, const std::string &value) {
       attr == ha_attr_type::source_list ||
       attr == ha_attr_type::options) {
     // todo: remove this when esphome starts sending properly formatted array strings
-    this->attributes_[attr] = convert_python_arr_str(value);
+    value = convert_python_arr_str(value);
     
     // only store the first 14 effects as additonal ones will never be rendered
     if (attr == ha_attr_type::effect_list) {
-      auto split_pos = find_nth_of(',', 15, this->attributes_[attr]);
+      auto split_pos = find_nth_of(',', 15, value);
       if (split_pos != std::string::npos) {
-        this->attributes_[attr] = this->attributes_[attr].substr(0, split_pos);
+        value.erase(split_pos);
       }
     }
-    this->attributes_[attr].shrink_to_fit();
-  } else {
-    this->attributes_[attr] = value;
+    value.shrink_to_fit();
   }
 
-  if (this->enable_notifications_) {
-    this->notify_attribute_change(attr, this->attributes_[attr]);
+  // the converted value is compared, so an update which doesn't change
+  // what is displayed isn't flagged as a change
+  auto it = this->attributes_.find(attr);
+  if (it == this->attributes_.end()) {
+    this->attributes_.emplace(attr, std::move(value));
+  } else if (it->second == value) {
+    return;
+  } else {
+    it->second = std::move(value);
   }
+
+  this->mark_changed(attr);
 }
 
-void Entity::notify_type_change(const char *type) {
+void Entity::notify_type_change(entity_kind kind) {
   for (auto iter = this->targets_.begin(); iter != this->targets_.end(); ++iter) {
-    (*iter)->on_entity_type_change(type);
+    (*iter)->on_entity_type_change(kind);
   }
 }
 
-void Entity::notify_state_change(const std::string &state) {
-  for (auto iter = this->targets_.begin(); iter != this->targets_.end(); ++iter) {
-    (*iter)->on_entity_state_change(state);
+void Entity::restore_attribute(ha_attr_type attr, std::string value) {
+  if (attr == ha_attr_type::state) {
+    this->set_state(std::move(value));
+    return;
+  }
+  if (attr == ha_attr_type::unknown || value.empty()) return;
+  this->attributes_[attr] = std::move(value);
+  this->mark_changed(attr);
+}
+
+void Entity::mark_changed(ha_attr_type attr) {
+  if (this->enable_notifications_) {
+    this->changed_ |= to_mask(attr);
   }
 }
 
-void Entity::notify_attribute_change(ha_attr_type attr, const std::string &value) {
+void Entity::flush_changes() {
+  if (this->changed_ == 0) return;
+  // clear first so subscribers can safely modify the entity
+  auto changed = this->changed_;
+  this->changed_ = 0;
   for (auto iter = this->targets_.begin(); iter != this->targets_.end(); ++iter) {
-    (*iter)->on_entity_attribute_change(attr, value);
+    (*iter)->on_entity_changed(changed);
   }
 }
 
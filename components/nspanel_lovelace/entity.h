@@ -14,15 +14,15 @@ namespace nspanel_lovelace {
 struct IEntitySubscriber {
 public:
   virtual ~IEntitySubscriber() {}
-  virtual void on_entity_type_change(const char *type) {}
-  virtual void on_entity_state_change(const std::string &state) {}
-  virtual void on_entity_attribute_change(ha_attr_type attr, const std::string &value) {}
+  virtual void on_entity_type_change(entity_kind kind) {}
+  // Called once per Entity::flush_changes(), the state is flagged as ha_attr_type::state
+  virtual void on_entity_changed(ha_attr_mask changed) {}
 };
 
 class Entity {
 public:
   Entity(const std::string &entity_id);
-  Entity(const std::string &entity_id, const char *type);
+  Entity(const std::string &entity_id, entity_kind kind);
 
   void add_subscriber(IEntitySubscriber *const target);
   bool remove_subscriber(const IEntitySubscriber *const target);
@@ -30,30 +30,49 @@ public:
   const std::string &get_entity_id() const;
   void set_entity_id(const std::string &entity_id);
   
-  bool is_type(const char *type) const;
-  const char *get_type() const;
-  bool set_type(const char *type);
+  bool is_type(entity_kind kind) const { return this->kind_ == kind; }
+  entity_kind get_type() const { return this->kind_; }
+  const char *get_type_str() const { return to_string(this->kind_); }
+  bool set_type(entity_kind kind);
 
   bool is_state(const std::string &state) const;
   const std::string &get_state() const;
-  void set_state(const std::string &state);
+  void set_state(std::string state);
 
   bool has_attribute(ha_attr_type attr) const;
   const std::string &get_attribute(ha_attr_type attr, const std::string &default_value = "") const;
-  void set_attribute(ha_attr_type attr, const std::string &value);
+  // the value is moved into storage, pass an rvalue to avoid copying it
+  void set_attribute(ha_attr_type attr, std::string value);
+  const std::map<ha_attr_type, std::string> &get_attributes() const { return this->attributes_; }
+  // Sets an already converted value, eg. from the state snapshot
+  void restore_attribute(ha_attr_type attr, std::string value);
+
+  // Where the entity is displayed, decides which attributes are subscribed to
+  entity_usage get_usage() const { return this->usage_; }
+  void set_usage(entity_usage usage) { this->usage_ = usage; }
+  // Attributes which are always subscribed to, regardless of usage
+  ha_attr_mask get_extra_attributes() const { return this->extra_attrs_; }
+  void set_extra_attributes(ha_attr_mask attrs) { this->extra_attrs_ = attrs; }
+
+  // State and attribute changes are collected until flush_changes() is called
+  bool has_changes() const { return this->changed_ != 0; }
+  ha_attr_mask get_changes() const { return this->changed_; }
+  void flush_changes();
 
 protected:
   std::string entity_id_;
-  const char *type_;
+  entity_kind kind_ = entity_kind::unknown;
   bool type_overridden_ = false;
+  entity_usage usage_ = entity_usage::all;
+  ha_attr_mask extra_attrs_ = 0;
   std::string state_;
   std::map<ha_attr_type, std::string> attributes_;
   std::vector<IEntitySubscriber*> targets_;
   bool enable_notifications_ = false;
+  ha_attr_mask changed_ = 0;
 
-  void notify_type_change(const char *type);
-  void notify_state_change(const std::string &state);
-  void notify_attribute_change(ha_attr_type attr, const std::string &value);
+  void notify_type_change(entity_kind kind);
+  void mark_changed(ha_attr_type attr);
 };
 
 }
@@ -1,17 +1,21 @@
 #pragma once
 
 #include "defines.h"
+#include "esphome/core/log.h"
 
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <ctype.h>
 #include <esp_heap_caps.h>
 #include <math.h>
 #include <stdint.h>
 #include <string>
+#include <string_view>
 #include <time.h>
+#include <type_traits>
 #include <vector>
 
 namespace esphome {
@@ -82,6 +86,15 @@ inline double value_or_default(const std::string &str, double default_value) {
     ? default_value : std::stod(str);
 }
 
+// True when both strings are numbers with the same value, e.g. "42" and "42.0"
+inline bool is_same_number(const std::string &a, const std::string &b) {
+  if (a.empty() || b.empty()) return false;
+  char *a_end, *b_end;
+  double a_value = std::strtod(a.c_str(), &a_end);
+  double b_value = std::strtod(b.c_str(), &b_end);
+  return *a_end == '\0' && *b_end == '\0' && a_value == b_value;
+}
+
 inline bool iso8601_to_tm(const char* iso8601_string, tm &t) {
   if (iso8601_string == nullptr) return false;
   
@@ -189,6 +202,39 @@ inline static constexpr bool str_equal(const char *a, const char *b) {
   return a == b || (a != nullptr && b != nullptr && std::strcmp(a, b) == 0);
 }
 
+constexpr size_t const_strlen(const char *str) {
+  size_t len = 0;
+  while (str[len] != '\0') len++;
+  return len;
+}
+
+constexpr size_t const_uint_digits(uint32_t value) {
+  size_t digits = 1;
+  while (value >= 10) {
+    value /= 10;
+    digits++;
+  }
+  return digits;
+}
+
+// Compares the first a_length chars of a (not null terminated) with b
+constexpr bool const_str_equal(const char *a, size_t a_length, const char *b) {
+  for (size_t i = 0; i < a_length; i++) {
+    if (b[i] != a[i] || b[i] == '\0') return false;
+  }
+  return b[a_length] == '\0';
+}
+
+// FNV-1a hash where the top 'bits' are returned as a table index,
+// used to build compile time perfect hash tables
+constexpr uint8_t fnv1a_hash_slot(const char *str, size_t length, uint32_t seed, uint8_t bits) {
+  uint32_t hash = seed;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ static_cast<uint8_t>(str[i])) * 16777619UL;
+  }
+  return static_cast<uint8_t>(hash >> (32 - bits));
+}
+
 inline void split_str(char delimiter, const std::string &str, std::vector<std::string> &array, uint16_t max_items = UINT16_MAX) {
   size_t pos_start = 0, pos_end = 0;
   std::string item;
@@ -270,11 +316,158 @@ inline std::string to_string(const std::vector<uint8_t> &array,
   return to_string(str_array, delimiter, prepend_char, append_char);
 }
 
+// Copies src to dest, dest is reallocated to exactly the required size
+// when it is too small instead of using the std::string growth policy
+template<class TString>
+inline TString &assign_exact(TString &dest, const std::string &src) {
+  if (dest.capacity() < src.length()) {
+    TString resized;
+    resized.reserve(src.length());
+    dest.swap(resized);
+  }
+  return dest.assign(src.data(), src.length());
+}
+
+// Integer types which are formatted as numbers, char and bool aren't
+template<class T>
+inline constexpr bool is_integer_number_v = std::is_integral<T>::value &&
+  !std::is_same<T, bool>::value && !std::is_same<T, char>::value;
+
+// Formats a number into a small stack buffer so it can be appended to a
+// string without allocating, e.g. buffer.append(num_str(value))
+class num_str {
+public:
+  // A template rather than int32_t/uint32_t overloads, those are long and
+  // unsigned long on ESP-IDF 5 so a uint8_t or int would be ambiguous.
+  // Values are formatted as 32 bit.
+  template<class T, typename std::enable_if<is_integer_number_v<T>, int>::type = 0>
+  num_str(T value) {
+    if constexpr (std::is_signed<T>::value) {
+      this->set_begin_(write_int_(this->end_(), static_cast<int32_t>(value), 0));
+    } else {
+      this->set_begin_(write_uint_(this->end_(), static_cast<uint32_t>(value)));
+    }
+  }
+
+  // value is already scaled, e.g. fixed(215, 1) is "21.5"
+  template<class T, typename std::enable_if<is_integer_number_v<T>, int>::type = 0>
+  static num_str fixed(T value, uint8_t decimals) {
+    num_str str;
+    str.set_begin_(write_int_(str.end_(), static_cast<int32_t>(value), decimals));
+    return str;
+  }
+  static num_str fixed(float value, uint8_t decimals) {
+    float scale = 1.0f;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10.0f;
+    return fixed(static_cast<int32_t>(lroundf(value * scale)), decimals);
+  }
+
+  const char *data() const { return this->data_ + this->begin_; }
+  size_t length() const { return sizeof(this->data_) - this->begin_; }
+  operator std::string_view() const { return {this->data(), this->length()}; }
+
+protected:
+  num_str() = default;
+
+  char *end_() { return this->data_ + sizeof(this->data_); }
+  void set_begin_(const char *begin) { this->begin_ = begin - this->data_; }
+
+  // digits are written backwards from end, two at a time
+  static char *write_uint_(char *end, uint32_t value) {
+    static constexpr const char digit_pairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+    while (value >= 100) {
+      const uint32_t i = (value % 100) * 2;
+      value /= 100;
+      *--end = digit_pairs[i + 1];
+      *--end = digit_pairs[i];
+    }
+    if (value >= 10) {
+      *--end = digit_pairs[value * 2 + 1];
+      *--end = digit_pairs[value * 2];
+    } else {
+      *--end = static_cast<char>('0' + value);
+    }
+    return end;
+  }
+
+  static char *write_int_(char *end, int32_t value, uint8_t decimals) {
+    uint32_t abs_value = value < 0
+      ? 0U - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    if (decimals > 0) {
+      for (uint8_t i = 0; i < decimals; i++) {
+        *--end = static_cast<char>('0' + abs_value % 10);
+        abs_value /= 10;
+      }
+      *--end = '.';
+    }
+    end = write_uint_(end, abs_value);
+    if (value < 0) *--end = '-';
+    return end;
+  }
+
+  // sign, 10 digits and up to 9 decimals with the point
+  char data_[21];
+  // offset of the first char in data_, an offset keeps copies valid
+  uint8_t begin_;
+};
+
+// Decimal string of a compile time value, e.g. uint_chars<6371>.data() is "6371"
+template<uint32_t Value>
+constexpr std::array<char, const_uint_digits(Value) + 1> make_uint_chars() {
+  std::array<char, const_uint_digits(Value) + 1> chars{};
+  uint32_t value = Value;
+  for (size_t i = const_uint_digits(Value); i > 0; i--) {
+    chars[i - 1] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return chars;
+}
+template<uint32_t Value>
+inline constexpr auto uint_chars = make_uint_chars<Value>();
+
 inline bool psram_available() {
   return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0 && 
       heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0;
 }
 
+// Allocates from PSRAM when there is some and falls back to internal RAM,
+// used for long lived buffers which aren't accessed often
+template<class T>
+struct PsramAllocator {
+  using value_type = T;
+
+  PsramAllocator() = default;
+  template<class U>
+  constexpr PsramAllocator(const PsramAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    void *ptr = nullptr;
+    if (psram_available())
+      ptr = heap_caps_malloc(n * sizeof(T), MALLOC_CAP_SPIRAM);
+    if (ptr == nullptr)
+      ptr = heap_caps_malloc(n * sizeof(T), MALLOC_CAP_DEFAULT);
+    if (ptr == nullptr) {
+      // built without exceptions, returning nullptr would be written through
+      ESP_LOGE("nspanel_lovelace", "Out of memory allocating %zu bytes", n * sizeof(T));
+      abort();
+    }
+    return static_cast<T *>(ptr);
+  }
+  void deallocate(T *ptr, size_t) noexcept {
+    heap_caps_free(ptr);
+  }
+
+  template<class U>
+  bool operator==(const PsramAllocator<U> &) const noexcept { return true; }
+  template<class U>
+  bool operator!=(const PsramAllocator<U> &) const noexcept { return false; }
+};
+
+using psram_string = std::basic_string<char, std::char_traits<char>, PsramAllocator<char>>;
+
 inline size_t psram_used() {
   return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) - 
       heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
@@ -20,6 +20,7 @@
 
 #include "cards.h"
 #include "card_items.h"
+#include "command_writer.h"
 #include "pages.h"
 #include "page_item_visitor.h"
 #include "page_visitor.h"
@@ -56,8 +57,17 @@ using SpiRamJsonDocument = BasicJsonDocument<SpiRamAllocator>;
 
 static const char *const TAG = "nspanel_lovelace";
 
+// NSPANEL_EXTRA_SUBSCRIPTIONS is generated from the yaml config (see __init__.py)
+#ifdef NSPANEL_EXTRA_SUBSCRIPTIONS
+static constexpr entity_subscription ENTITY_EXTRA_SUBSCRIPTIONS[] = {
+  NSPANEL_EXTRA_SUBSCRIPTIONS
+};
+#endif
+
 NSPanelLovelace::NSPanelLovelace() {
   command_buffer_.reserve(1024);
+  control_intervals_.fill(CONTROL_MIN_INTERVAL);
+  service_call_.data.reserve(HA_SERVICE_MAX_DATA);
 }
 
 bool NSPanelLovelace::restore_state_() {
@@ -77,10 +87,102 @@ bool NSPanelLovelace::save_state_() {
   return this->pref_.save(&state);
 }
 
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+uint32_t NSPanelLovelace::get_entities_hash_() const {
+  uint32_t hash = 0;
+  for (auto &entity : this->entities_) {
+    hash = (hash * 31) + fnv1_hash(entity->get_entity_id());
+  }
+  return hash;
+}
+
+bool NSPanelLovelace::restore_state_snapshot_() {
+  this->snapshot_pref_ = global_preferences->make_preference<NSPanelStateSnapshot>(STATE_SNAPSHOT_VERSION);
+  std::unique_ptr<NSPanelStateSnapshot> snapshot(new NSPanelStateSnapshot());
+  if (!this->snapshot_pref_.load(snapshot.get())) return false;
+  if (snapshot->entities_hash != this->get_entities_hash_() ||
+      snapshot->length > STATE_SNAPSHOT_SIZE) {
+    ESP_LOGD(TAG, "State snapshot discarded, entities changed");
+    return false;
+  }
+
+  const uint8_t *data = snapshot->data;
+  uint16_t pos = 0, count = 0;
+  while (pos + 3 <= snapshot->length) {
+    uint8_t index = data[pos];
+    auto attr = static_cast<ha_attr_type>(data[pos + 1]);
+    uint8_t length = data[pos + 2];
+    pos += 3;
+    if (pos + length > snapshot->length || index >= this->entities_.size()) break;
+    this->entities_[index]->restore_attribute(attr,
+      std::string(reinterpret_cast<const char *>(data + pos), length));
+    pos += length;
+    count++;
+  }
+  for (auto &entity : this->entities_) {
+    entity->flush_changes();
+  }
+  // avoids re-writing an identical snapshot
+  this->state_snapshot_crc_ = crc16(data, snapshot->length);
+  ESP_LOGD(TAG, "State snapshot restored %u values", count);
+  return true;
+}
+
+bool NSPanelLovelace::save_state_snapshot_() {
+  if (!this->state_snapshot_dirty_) return false;
+  this->state_snapshot_dirty_ = false;
+
+  std::unique_ptr<NSPanelStateSnapshot> snapshot(new NSPanelStateSnapshot());
+  snapshot->entities_hash = this->get_entities_hash_();
+  uint8_t *data = snapshot->data;
+  uint16_t pos = 0;
+  auto append = [data, &pos](uint8_t index, ha_attr_type attr, const std::string &value) {
+    if (value.empty() || value.size() > STATE_SNAPSHOT_MAX_VALUE_LENGTH) return true;
+    if (pos + 3 + value.size() > STATE_SNAPSHOT_SIZE) return false;
+    data[pos++] = index;
+    data[pos++] = static_cast<uint8_t>(attr);
+    data[pos++] = static_cast<uint8_t>(value.size());
+    std::memcpy(data + pos, value.data(), value.size());
+    pos += value.size();
+    return true;
+  };
+
+  // states have priority, attributes are added while there is space left
+  size_t entity_count = std::min<size_t>(this->entities_.size(), UINT8_MAX);
+  bool full = false;
+  for (size_t i = 0; i < entity_count && !full; i++) {
+    auto &state = this->entities_[i]->get_state();
+    if (state == entity_state::unknown) continue;
+    full = !append(i, ha_attr_type::state, state);
+  }
+  for (size_t i = 0; i < entity_count && !full; i++) {
+    for (auto &attr : this->entities_[i]->get_attributes()) {
+      if ((full = !append(i, attr.first, attr.second))) break;
+    }
+  }
+  snapshot->length = pos;
+
+  auto crc = crc16(data, pos);
+  if (crc == this->state_snapshot_crc_) return false;
+  if (!this->snapshot_pref_.save(snapshot.get())) return false;
+  this->state_snapshot_crc_ = crc;
+  ESP_LOGD(TAG, "State snapshot saved (%u bytes)", pos);
+  return true;
+}
+#endif
+
 void NSPanelLovelace::setup() {
   this->default_baud_rate_ = this->parent_->get_baud_rate();
 
   this->restore_state_();
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+  // populate entities before the first render, live updates will follow
+  this->restore_state_snapshot_();
+  // the interval limits flash wear, nothing is written if nothing changed
+  this->set_interval("snapshot", this->state_snapshot_interval_, [this]() {
+    this->save_state_snapshot_();
+  });
+#endif
 
 #ifdef USE_TIME
   this->setup_time_();
@@ -101,209 +203,27 @@ void NSPanelLovelace::setup() {
         to_string(ha_attr_type::forecast));
   }
   
-  for (auto &entity : this->entities_) {
-    auto &entity_id = entity->get_entity_id();
-    ESP_LOGV(TAG, "Adding subscriptions for entity '%s'", entity_id.c_str());
-    bool add_state_subscription = false;
-    if (entity->is_type(entity_type::light)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::supported_color_modes));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::color_mode));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::min_mireds));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::max_mireds));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::color_temp));
-      // need to subscribe to brightness to know if brightness is supported
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::brightness));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::effect_list));
-    }
-    else if (entity->is_type(entity_type::switch_) ||
-        entity->is_type(entity_type::input_boolean) ||
-        entity->is_type(entity_type::input_text) ||
-        entity->is_type(entity_type::text) ||
-        entity->is_type(entity_type::automation) ||
-        entity->is_type(entity_type::sun) ||
-        entity->is_type(entity_type::vacuum) ||
-        entity->is_type(entity_type::lock) ||
-        entity->is_type(entity_type::person)) {
-      add_state_subscription = true;
-    }
-    // icons and unit_of_measurement based on state and device_class
-    else if (entity->is_type(entity_type::sensor) ||
-        entity->is_type(entity_type::binary_sensor)) {
-      add_state_subscription = true;
-      // if (!entity->is_icon_value_overridden()) {
-        this->subscribe_homeassistant_state_attr(
-            &NSPanelLovelace::on_entity_attribute_update_, 
-            entity_id, to_string(ha_attr_type::device_class));
-      // }
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::unit_of_measurement));
-    }
-    else if (entity->is_type(entity_type::cover)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::device_class));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::supported_features));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::current_position));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::current_tilt_position));
-    }
-    else if (entity->is_type(entity_type::alarm_control_panel)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::code_arm_required));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::open_sensors));
-    }
-    else if (entity->is_type(entity_type::timer)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::editable));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::duration));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::remaining));
-      this->subscribe_homeassistant_state_attr(
-        &NSPanelLovelace::on_entity_attribute_update_,
-        entity_id, to_string(ha_attr_type::finishes_at));
-    }
-    else if (entity->is_type(entity_type::climate)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::temperature));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::current_temperature));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::target_temp_high));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::target_temp_low));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::target_temp_step));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::min_temp));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::max_temp));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::hvac_action));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::preset_modes));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::swing_modes));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::fan_modes));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::hvac_modes));
-    }
-    else if (entity->is_type(entity_type::media_player)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::supported_features));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::media_content_type));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::media_title));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::media_artist));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::volume_level));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::shuffle));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::source_list));
-    }
-    else if (entity->is_type(entity_type::select) ||
-        entity->is_type(entity_type::input_select)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::options));
-    }
-    else if (entity->is_type(entity_type::number) ||
-        entity->is_type(entity_type::input_number)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::min));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::max));
-    }
-    else if (entity->is_type(entity_type::weather)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::temperature));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::temperature_unit));
-    }
-    else if (entity->is_type(entity_type::fan)) {
-      add_state_subscription = true;
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::percentage_step));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::percentage));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::preset_modes));
-      this->subscribe_homeassistant_state_attr(
-          &NSPanelLovelace::on_entity_attribute_update_, 
-          entity_id, to_string(ha_attr_type::preset_mode));
-    }
-
-    if (add_state_subscription) {
-      this->subscribe_homeassistant_state(
-        &NSPanelLovelace::on_entity_state_update_,
-        entity_id);
+  this->build_entity_references_();
+  this->entity_dirty_.assign(this->entities_.size(), false);
+  this->dirty_entities_.reserve(this->entities_.size());
+  size_t heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  for (uint16_t i = 0; i < this->entities_.size(); i++) {
+    auto &entity = this->entities_[i];
+    ESP_LOGV(TAG, "Adding subscriptions for entity '%s'", entity->get_entity_id().c_str());
+    ha_attr_mask attrs = entity->get_extra_attributes() |
+      get_entity_subscriptions(ENTITY_SUBSCRIPTIONS, entity->get_type(), entity->get_usage());
+#ifdef NSPANEL_EXTRA_SUBSCRIPTIONS
+    attrs |= get_entity_subscriptions(
+      ENTITY_EXTRA_SUBSCRIPTIONS, entity->get_type(), entity->get_usage());
+#endif
+    while (attrs != 0) {
+      this->subscribe_entity_(i, static_cast<ha_attr_type>(__builtin_ctzll(attrs)));
+      attrs &= attrs - 1;
+      this->subscription_count_++;
     }
   }
+  // includes the entity_id/attribute copies held by the api server
+  this->subscription_heap_used_ = heap_free - heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
 
   this->set_timeout(1000, [this]() {
     // The display isn't reset when ESP is reset (on ota update etc.)
@@ -340,6 +260,14 @@ void NSPanelLovelace::loop() {
     }
   }
 
+  if (!this->dirty_entities_.empty() &&
+      (millis() - this->flush_started_) >= this->flush_delay_) {
+    this->flush_dirty_entities_();
+  }
+
+  this->process_pending_controls_();
+  this->expire_optimistic_updates_();
+
   if (this->force_current_page_update_) {
     this->force_current_page_update_ = false;
     ESP_LOGD(TAG, "Render HA update");
@@ -354,6 +282,13 @@ void NSPanelLovelace::loop() {
   if ((millis() - this->command_last_sent_) > COMMAND_COOLDOWN) {
     this->process_display_command_queue_();
   }
+
+  // nothing received or waiting to be sent, get the pages the user
+  // is likely to swipe to ready so only a copy is needed then
+  if (this->buffer_.empty() && this->command_queue_.empty() &&
+      this->dirty_entities_.empty()) {
+    this->prerender_neighbour_pages_();
+  }
 }
 
 std::shared_ptr<Entity> NSPanelLovelace::create_entity(const std::string &entity_id) {
@@ -365,6 +300,14 @@ std::shared_ptr<Entity> NSPanelLovelace::create_entity(const std::string &entity
   return entity;
 }
 
+std::shared_ptr<Entity> NSPanelLovelace::create_entity(const std::string &entity_id,
+    entity_usage usage, ha_attr_mask extra_attrs) {
+  auto entity = this->create_entity(entity_id);
+  entity->set_usage(usage);
+  entity->set_extra_attributes(extra_attrs);
+  return entity;
+}
+
 void NSPanelLovelace::on_page_item_added_callback(const std::shared_ptr<PageItem> &item) {
   bool found = false;
   auto &item_uuid = item->get_uuid();
@@ -389,7 +332,7 @@ void NSPanelLovelace::on_page_item_added_callback(const std::shared_ptr<PageItem
 void NSPanelLovelace::set_display_timeout(uint16_t timeout) {
   this->command_buffer_
     .assign("timeout").append(1, SEPARATOR)
-    .append(esphome::to_string(timeout));
+    .append(num_str(timeout));
   this->send_buffered_command_();
 }
 
@@ -424,11 +367,11 @@ void NSPanelLovelace::set_display_dim(uint8_t inactive, uint8_t active) {
   this->command_buffer_
     .assign("dimmode").append(1, SEPARATOR)
     // brightness when inactive (after timeout reached)
-    .append(esphome::to_string(this->display_inactive_dim_)).append(1, SEPARATOR)
+    .append(num_str(this->display_inactive_dim_)).append(1, SEPARATOR)
     // brightness when active (when buttons pressed)
-    .append(esphome::to_string(this->display_active_dim_)).append(1, SEPARATOR)
+    .append(num_str(this->display_active_dim_)).append(1, SEPARATOR)
     // background colour when active (not screensaver background, defaults to ha-dark)
-    .append(esphome::to_string(6371));
+    .append(ui_color::ha_dark);
   
   this->send_buffered_command_();
 }
@@ -475,13 +418,13 @@ bool NSPanelLovelace::process_data_() {
   uint16_t length = encode_uint16(data[3], data[2]);
 
   // Wait until all data comes in
-  if (at - 4 < length) {
+  if (at - 4 < static_cast<uint32_t>(length)) {
     //    ESP_LOGD(TAG, "Message (%d/%d): 0x%02x", at - 3, length, new_byte);
     return true;
   }
 
   // Last two bytes: CRC; return after first one
-  if (at == 4 + length) {
+  if (at == 4u + length) {
     return true;
   }
 
@@ -532,7 +475,7 @@ void NSPanelLovelace::process_command_(const std::string &message) {
   } else if (tokens.at(1) == action_type::startup) {
     if (tokens.size() == 4) {
       uint16_t ver = 0;
-      if(std::sscanf(tokens.at(2).c_str(), "%" PRIu16, &ver) == 1) {
+      if(std::sscanf(tokens.at(2).c_str(), "%" SCNu16, &ver) == 1) {
         Configuration::set_version(ver);
       }
       Configuration::set_model(tokens.at(3));
@@ -566,28 +509,54 @@ void NSPanelLovelace::render_page_(size_t index) {
 }
 
 void NSPanelLovelace::render_page_(render_page_option d) {
-  uint8_t start_page_index = 1;
-  if (d == render_page_option::default_page) {
-    // todo: fetch default page from config
-    this->current_page_index_ = start_page_index;
-  } if (d == render_page_option::screensaver) {
-    this->current_page_index_ = this->screensaver_ == nullptr ? start_page_index : 0;
-  } else if (d == render_page_option::next) {
-    if (this->current_page_index_ == this->pages_.size() - 1)
-      this->current_page_index_ = start_page_index;
-    else 
-      ++this->current_page_index_;
-  } else if (d == render_page_option::prev) {
-    if (this->current_page_index_ <= start_page_index)
-      this->current_page_index_ = this->pages_.size() - 1;
-    else
-      --this->current_page_index_;
-  }
+  this->current_page_index_ = this->get_page_index_(d);
   this->current_page_ = this->pages_.at(this->current_page_index_).get();
   this->force_current_page_update_ = false;
   this->render_current_page_();
 }
 
+size_t NSPanelLovelace::get_page_index_(render_page_option d) const {
+  const size_t start_page_index = 1;
+  const size_t last_page_index = this->pages_.size() - 1;
+  switch (d) {
+    case render_page_option::default_page:
+      // todo: fetch default page from config
+      return start_page_index;
+    case render_page_option::screensaver:
+      return this->screensaver_ == nullptr ? start_page_index : 0;
+    case render_page_option::next:
+      return this->current_page_index_ == last_page_index
+        ? start_page_index : this->current_page_index_ + 1;
+    case render_page_option::prev:
+      return this->current_page_index_ <= start_page_index
+        ? last_page_index : this->current_page_index_ - 1;
+  }
+  return this->current_page_index_;
+}
+
+std::array<size_t, 3> NSPanelLovelace::get_neighbour_page_indexes_() const {
+  bool on_screensaver = this->screensaver_ != nullptr &&
+      this->current_page_ == this->screensaver_;
+  return {
+    this->get_page_index_(render_page_option::prev),
+    this->get_page_index_(render_page_option::next),
+    on_screensaver
+      ? this->get_page_index_(render_page_option::default_page)
+      : this->current_page_index_};
+}
+
+void NSPanelLovelace::prerender_neighbour_pages_() {
+  if (this->current_page_ == nullptr) return;
+  for (auto index : this->get_neighbour_page_indexes_()) {
+    if (index == this->current_page_index_) continue;
+    // one page per loop keeps it short
+    if (this->pages_[index]->prerender(this->prerender_scratch_)) {
+      this->prerender_count_++;
+      return;
+    }
+  }
+}
+
 void NSPanelLovelace::render_current_page_() {
   if (this->current_page_ == nullptr)
     this->render_page_(render_page_option::default_page);
@@ -599,22 +568,51 @@ void NSPanelLovelace::render_current_page_() {
   this->popup_page_current_uuid_.clear();
 
   this->set_display_timeout(this->current_page_->get_sleep_timeout());
+  this->update_entity_visibility_();
   
   this->render_item_update_(this->current_page_);
+  this->release_render_caches_();
+}
+
+void NSPanelLovelace::release_render_caches_() {
+  auto neighbours = this->get_neighbour_page_indexes_();
+  for (size_t i = 0; i < this->pages_.size(); i++) {
+    if (i == this->current_page_index_ ||
+        std::find(neighbours.begin(), neighbours.end(), i) != neighbours.end())
+      continue;
+    if (i == 0 && this->screensaver_ != nullptr) continue;
+    this->pages_[i]->release_render_cache();
+  }
 }
 
 void NSPanelLovelace::render_item_update_(Page *page) {
+  if (!this->deferred_entities_.empty()) {
+    this->flush_deferred_changes_();
+  }
+  render_stat_scope stat(this->get_render_stat_(
+    static_cast<uint8_t>(page->get_type())), this->command_buffer_);
   page->render(this->command_buffer_);
+  stat.finish();
   this->send_buffered_command_();
 
   if (page->is_type(page_type::screensaver) && this->screensaver_ != nullptr) {
     if (this->screensaver_->should_render_status_update()) {
+      render_stat_scope status_stat(this->get_render_stat_(
+        RENDER_STAT_STATUS_UPDATE), this->command_buffer_);
       this->screensaver_->render_status_update(this->command_buffer_);
+      status_stat.finish();
       this->send_buffered_command_();
     }
   }
 }
 
+render_stat *NSPanelLovelace::get_render_stat_(uint8_t slot) {
+#ifdef USE_NSPANEL_RENDER_STATS
+  if (slot < RENDER_STAT_COUNT) return &this->render_stats_[slot];
+#endif
+  return nullptr;
+}
+
 // entityUpdateDetail~{internalName}~{tHeading}~{tHeadingColor}~{b1}~{tB1Color}~{b2}~[tB2Color}~{tText}~{tTextColor}~{sleepTimeout}~{font}~{alt_icon}~{altIconColor}
 // Possible 'font' options:
 //    Font 0 - Default - Size 24 (No Icons, Support for various special chars from different langs)
@@ -631,7 +629,7 @@ void NSPanelLovelace::render_popup_notify_page_(const std::string &internal_id,
       .append(1, SEPARATOR).append("popupNotify");
   this->send_buffered_command_();
 
-  auto text_colour = std::to_string(65535U);
+  const char *text_colour = ui_color::white;
   this->command_buffer_
     .assign("entityUpdateDetail").append(1, SEPARATOR)
     .append(internal_id).append(1, SEPARATOR)
@@ -648,7 +646,7 @@ void NSPanelLovelace::render_popup_notify_page_(const std::string &internal_id,
     .append(message).append(1, SEPARATOR)
     .append(text_colour).append(1, SEPARATOR)
     // timeout
-    .append(std::to_string(timeout));
+    .append(num_str(timeout));
 
   this->send_buffered_command_();
 }
@@ -672,7 +670,7 @@ bool NSPanelLovelace::render_popup_page_update_(const std::string &internal_id)
     }
     bool rendered = false;
     if (this->current_page_->is_type(page_type::cardThermo)) {
-      if (entity->is_type(entity_type::climate)) {
+      if (entity->is_type(entity_kind::climate)) {
         this->render_climate_detail_update_(entity);
         rendered = true;
       }
@@ -709,34 +707,45 @@ bool NSPanelLovelace::render_popup_page_update_(const std::string &internal_id)
 
 bool NSPanelLovelace::render_popup_page_update_(StatefulPageItem *item) {
   if (item == nullptr) return false;
+  render_stat_scope stat(this->get_render_stat_(
+    RENDER_STAT_POPUP_DETAIL), this->command_buffer_);
+  item->update_state();
 
-  if (item->is_type(entity_type::light)) {
-    this->render_light_detail_update_(item);
-  } else if (item->is_type(entity_type::timer)) {
-    this->set_display_timeout(30);
-    this->render_timer_detail_update_(item);
-    this->set_interval(entity_type::timer, 1000, [this, item]() {
-      if (this->popup_page_current_uuid_ != item->get_uuid()) {
-        this->cancel_interval(entity_type::timer);
-        return;
-      }
+  switch(item->get_type()) {
+    case entity_kind::light:
+      this->render_light_detail_update_(item);
+      break;
+    case entity_kind::timer:
+      this->set_display_timeout(30);
       this->render_timer_detail_update_(item);
-    });
-  } else if (item->is_type(entity_type::cover)) {
-    this->render_cover_detail_update_(item);
-  } else if (item->is_type(entity_type::climate)) {
-    this->render_climate_detail_update_(item);
-  } else if (
-      item->is_type(entity_type::select) ||
-      item->is_type(entity_type::input_select) ||
-      item->is_type(entity_type::media_player)) {
-    this->render_input_select_detail_update_(item);
-  } else if (item->is_type(entity_type::fan)) {
-    this->render_fan_detail_update_(item);
-  } else {
-    return false;
+      this->set_interval(entity_type::timer, 1000, [this, item]() {
+        if (this->popup_page_current_uuid_ != item->get_uuid()) {
+          this->cancel_interval(entity_type::timer);
+          return;
+        }
+        this->render_timer_detail_update_(item);
+      });
+      break;
+    case entity_kind::cover:
+      this->render_cover_detail_update_(item);
+      break;
+    case entity_kind::climate:
+      this->render_climate_detail_update_(item);
+      break;
+    case entity_kind::select:
+    case entity_kind::input_select:
+    case entity_kind::media_player:
+      this->render_input_select_detail_update_(item);
+      break;
+    case entity_kind::fan:
+      this->render_fan_detail_update_(item);
+      break;
+    default:
+      stat.discard();
+      return false;
   }
 
+  stat.finish();
   this->send_buffered_command_();
   return true;
 }
@@ -755,10 +764,6 @@ void NSPanelLovelace::render_cover_detail_update_(StatefulPageItem *item) {
 
   auto &position_str = entity->
     get_attribute(ha_attr_type::current_position);
-  auto &supported_features_str = entity->
-    get_attribute(ha_attr_type::supported_features);
-  auto &tilt_position_str = entity->
-    get_attribute(ha_attr_type::current_tilt_position);
 
   uint8_t position = value_or_default(position_str, 0U);
   uint8_t tilt_position = value_or_default(entity->
@@ -775,8 +780,8 @@ void NSPanelLovelace::render_cover_detail_update_(StatefulPageItem *item) {
   const icon_char_t* icon_tilt_stop = icon_t::none;
   const icon_char_t* icon_tilt_right = icon_t::none;
 
-  std::string text_position = "";
-  std::string text_tilt = "";
+  const char *text_position = "";
+  const char *text_tilt = "";
 
   // Icon Status
   bool icon_up_status = false;
@@ -857,61 +862,51 @@ void NSPanelLovelace::render_cover_detail_update_(StatefulPageItem *item) {
     }
   }
 
-  this->command_buffer_
-    // entityUpdateDetail~
-    .assign("entityUpdateDetail").append(1, SEPARATOR)
+  command_writer writer(this->command_buffer_, "entityUpdateDetail");
+  writer
     // entity_id~
-    .append("uuid.").append(item->get_uuid()).append(1, SEPARATOR)
+    .uuid(item->get_uuid())
     // slider_pos~
-    .append(esphome::to_string(position)).append(1, SEPARATOR)
+    .field(position)
     // position text + state / value~
-    .append(text_position).append(": ")
-    .append(position_status
-      ? esphome::to_string(position).append("%")
-      : entity->get_state())
-    .append(1, SEPARATOR)
+    .field(text_position).append(": ");
+  if (position_status)
+    writer.append(position).append_char('%');
+  else
+    writer.append(entity->get_state());
+  writer
     // position text~
-    .append(text_position).append(1, SEPARATOR)
+    .field(text_position)
     // icon~
-    .append(CHAR8_CAST(cover_icon)).append(1, SEPARATOR)
+    .field(cover_icon)
     // icon_up~
-    .append(CHAR8_CAST(icon_up)).append(1, SEPARATOR)
+    .field(icon_up)
     // icon_stop~
-    .append(CHAR8_CAST(icon_stop)).append(1, SEPARATOR)
+    .field(icon_stop)
     // icon_down~
-    .append(CHAR8_CAST(icon_down)).append(1, SEPARATOR)
+    .field(icon_down)
     // icon_up_status~
-    .append(icon_up_status ? generic_type::enable : generic_type::disable)
-    .append(1, SEPARATOR)
+    .flag(icon_up_status)
     // icon_stop_status~
-    .append(icon_stop_status ? generic_type::enable : generic_type::disable)
-    .append(1, SEPARATOR)
+    .flag(icon_stop_status)
     // icon_down_status~
-    .append(icon_down_status ? generic_type::enable : generic_type::disable)
-    .append(1, SEPARATOR)
+    .flag(icon_down_status)
     // tilt text~
-    .append(text_tilt).append(1, SEPARATOR)
+    .field(text_tilt)
     // icon_tilt_left~
-    .append(CHAR8_CAST(icon_tilt_left)).append(1, SEPARATOR)
+    .field(icon_tilt_left)
     // icon_tilt_stop~
-    .append(CHAR8_CAST(icon_tilt_stop)).append(1, SEPARATOR)
+    .field(icon_tilt_stop)
     // icon_tilt_right~
-    .append(CHAR8_CAST(icon_tilt_right)).append(1, SEPARATOR)
+    .field(icon_tilt_right)
     // icon_tilt_left_status~
-    .append(icon_tilt_left_status
-      ? generic_type::enable : generic_type::disable)
-    .append(1, SEPARATOR)
+    .flag(icon_tilt_left_status)
     // icon_tilt_stop_status~
-    .append(icon_tilt_stop_status
-      ? generic_type::enable : generic_type::disable)
-    .append(1, SEPARATOR)
+    .flag(icon_tilt_stop_status)
     // icon_tilt_right_status~
-    .append(icon_tilt_right_status
-      ? generic_type::enable : generic_type::disable)
-    .append(1, SEPARATOR)
+    .flag(icon_tilt_right_status)
     // tilt_position_status
-    .append(tilt_position_status
-      ? std::to_string(tilt_position).append("%") : generic_type::disable);
+    .percent_or_disable(tilt_position_status, tilt_position);
 }
 
 // entityUpdateDetail~{entity_id}~~{icon_color}~{switch_val}~{brightness}~{color_temp}~{color}~{color_translation}~{color_temp_translation}~{brightness_translation}~{effect_supported}
@@ -919,50 +914,49 @@ void NSPanelLovelace::render_light_detail_update_(StatefulPageItem *item) {
   if (item == nullptr) return;
 
   auto entity = item->get_entity();
-  auto &supported_modes = entity->get_attribute(ha_attr_type::supported_color_modes);
-  bool enable_color_wheel = entity->is_state(entity_state::on) &&
-      (contains_value(supported_modes, ha_attr_color_mode::xy) || 
-      contains_value(supported_modes, ha_attr_color_mode::hs) ||
-      contains_value(supported_modes, ha_attr_color_mode::rgb) ||
-      contains_value(supported_modes, ha_attr_color_mode::rgbw) ||
-      contains_value(supported_modes, ha_attr_color_mode::rgbww));
-
-  std::string color_mode = entity->get_attribute(ha_attr_type::color_mode);
-  std::string color_temp = generic_type::disable;
-  if (contains_value(supported_modes, ha_attr_color_mode::color_temp)) {
-    if (color_mode == ha_attr_color_mode::color_temp) {
-      color_temp = entity->get_attribute(ha_attr_type::color_temp, generic_type::disable);
-    } else {
-      color_temp = entity_state::unknown;
-    }
-  } else {
-    color_temp = generic_type::disable;
-  }
-
-  this->command_buffer_
-    // entityUpdateDetail~
-    .assign("entityUpdateDetail").append(1, SEPARATOR)
+  bool enable_color_wheel = false, color_temp_supported = false;
+  // empty attributes aren't stored
+  if (entity->has_attribute(ha_attr_type::supported_color_modes)) {
+    auto &supported_modes = entity->get_attribute(ha_attr_type::supported_color_modes);
+    enable_color_wheel = entity->is_state(entity_state::on) &&
+        (contains_value(supported_modes, ha_attr_color_mode::xy) ||
+        contains_value(supported_modes, ha_attr_color_mode::hs) ||
+        contains_value(supported_modes, ha_attr_color_mode::rgb) ||
+        contains_value(supported_modes, ha_attr_color_mode::rgbw) ||
+        contains_value(supported_modes, ha_attr_color_mode::rgbww));
+    color_temp_supported =
+        contains_value(supported_modes, ha_attr_color_mode::color_temp);
+  }
+
+  command_writer writer(this->command_buffer_, "entityUpdateDetail");
+  writer
     // entity_id~~
-    .append("uuid.").append(item->get_uuid()).append(2, SEPARATOR)
+    .uuid(item->get_uuid()).field()
     // icon_color~
-    .append(item->get_icon_color_str()).append(1, SEPARATOR)
+    .field(item->get_icon_color_str())
     // switch_val~
-    .append(std::to_string(entity->is_state(entity_state::on) ? 1 : 0)).append(1, SEPARATOR)
+    .bit(entity->is_state(entity_state::on))
     // brightness~ (0-100)
-    .append(entity->get_attribute(ha_attr_type::brightness, generic_type::disable)).append(1, SEPARATOR)
-    // color_temp~ (color temperature value or 'disable')
-    .append(color_temp).append(1, SEPARATOR)
+    .field(entity->get_attribute(ha_attr_type::brightness, generic_type::disable));
+  // color_temp~ (color temperature value or 'disable')
+  if (!color_temp_supported)
+    writer.field(generic_type::disable);
+  else if (entity->get_attribute(ha_attr_type::color_mode) ==
+      ha_attr_color_mode::color_temp)
+    writer.field(entity->get_attribute(ha_attr_type::color_temp, generic_type::disable));
+  else
+    writer.field(entity_state::unknown);
+  writer
     // color~ ('enable' or 'disable')
-    .append(enable_color_wheel ? generic_type::enable : generic_type::disable).append(1, SEPARATOR)
+    .flag(enable_color_wheel)
     // color_translation~
-    .append(get_translation(translation_item::color)).append(1, SEPARATOR)
+    .field(get_translation(translation_item::color))
     // color_temp_translation~
-    .append(get_translation(translation_item::color_temp)).append(1, SEPARATOR)
+    .field(get_translation(translation_item::color_temp))
     // brightness_translation~
-    .append(get_translation(translation_item::brightness)).append(1, SEPARATOR)
+    .field(get_translation(translation_item::brightness))
     // effect_supported ('enable' or 'disable')
-    .append(entity->has_attribute(ha_attr_type::effect_list) ?
-      generic_type::enable : generic_type::disable);
+    .flag(entity->has_attribute(ha_attr_type::effect_list));
 }
 
 // entityUpdateDetail~{entity_id}~~{icon_color}~{entity_id}~{min_remaining}~{sec_remaining}~{editable}~{action1}~{action2}~{action3}~{label1}~{label2}~{label3}
@@ -976,39 +970,31 @@ void NSPanelLovelace::render_timer_detail_update_(StatefulPageItem *item) {
 
   if (idle) {
     this->cancel_interval(entity_type::timer);
-    std::string time_remaining_str;
-    if (state == entity_state::paused) {
-      time_remaining_str = item->get_attribute(ha_attr_type::remaining);
-    } else {
-      time_remaining_str = item->get_attribute(ha_attr_type::duration);
-    }
-    if (!time_remaining_str.empty()) {
-      std::vector<std::string> time_parts;
-      split_str(':', time_remaining_str, time_parts);
-      if (time_parts.size() == 3) {
-        min_remaining = (stoi(time_parts[0]) * 60) + stoi(time_parts[1]);
-        sec_remaining = stoi(time_parts[2]);
-        render = true;
-      }
-    }
-  }
-  // active
-  else {
+    // h:mm:ss
+    int hours = 0, minutes = 0, seconds = 0;
+    if (sscanf(item->get_attribute(state == entity_state::paused
+          ? ha_attr_type::remaining : ha_attr_type::duration).c_str(),
+        "%d:%d:%d", &hours, &minutes, &seconds) == 3) {
+      min_remaining = (hours * 60) + minutes;
+      sec_remaining = seconds;
+      render = true;
+    }
+  }
+  // active, empty attributes aren't stored
+  else if (item->get_entity()->has_attribute(ha_attr_type::finishes_at)) {
     auto &finishes_at = item->get_attribute(ha_attr_type::finishes_at);
-    if (!finishes_at.empty()) {
-      tm t{};
-      if (iso8601_to_tm(finishes_at.c_str(), t)) {
-        ESPTime now = this->time_id_.value()->now();
-        if (now.is_valid()) {
-          double seconds = difftime(mktime(&t), now.timestamp);
-          if (seconds >= UINT16_MAX) seconds = UINT16_MAX;
-          if (seconds < 0) seconds = 0;
-          min_remaining = static_cast<uint16_t>(seconds) / 60;
-          sec_remaining = static_cast<uint16_t>(seconds) % 60;
-          render = true;
-          if (seconds == 0) {
-            this->cancel_interval(entity_type::timer);
-          }
+    tm t{};
+    if (iso8601_to_tm(finishes_at.c_str(), t)) {
+      ESPTime now = this->time_id_.value()->now();
+      if (now.is_valid()) {
+        double seconds = difftime(mktime(&t), now.timestamp);
+        if (seconds >= UINT16_MAX) seconds = UINT16_MAX;
+        if (seconds < 0) seconds = 0;
+        min_remaining = static_cast<uint16_t>(seconds) / 60;
+        sec_remaining = static_cast<uint16_t>(seconds) % 60;
+        render = true;
+        if (seconds == 0) {
+          this->cancel_interval(entity_type::timer);
         }
       }
     }
@@ -1019,41 +1005,32 @@ void NSPanelLovelace::render_timer_detail_update_(StatefulPageItem *item) {
     return;
   }
 
-  this->command_buffer_
-    // entityUpdateDetail~
-    .assign("entityUpdateDetail").append(1, SEPARATOR)
+  command_writer(this->command_buffer_, "entityUpdateDetail")
     // entity_id~~
-    .append("uuid.").append(item->get_uuid()).append(2, SEPARATOR)
+    .uuid(item->get_uuid()).field()
     // icon_color~
-    .append(item->get_icon_color_str()).append(1, SEPARATOR)
-    // entity_id~~
-    .append("uuid.").append(item->get_uuid()).append(1, SEPARATOR)
+    .field(item->get_icon_color_str())
+    // entity_id~
+    .uuid(item->get_uuid())
     // min_remaining~
-    .append(std::to_string(min_remaining)).append(1, SEPARATOR)
+    .field(min_remaining)
     // sec_remaining~
-    .append(std::to_string(sec_remaining)).append(1, SEPARATOR)
+    .field(sec_remaining)
     // editable~
-    .append((idle && 
-      item->get_attribute(ha_attr_type::editable) == entity_state::on)
-        ? "1" : "0")
-    .append(1, SEPARATOR)
+    .bit(idle && item->get_attribute(ha_attr_type::editable) == entity_state::on)
     // action1~
-    .append(idle ? "" : ha_action_type::pause).append(1, SEPARATOR)
+    .field(idle ? "" : ha_action_type::pause)
     // action2~
-    .append(idle ? ha_action_type::start : ha_action_type::cancel)
-    .append(1, SEPARATOR)
+    .field(idle ? ha_action_type::start : ha_action_type::cancel)
     // action3~
-    .append(idle ? "" : ha_action_type::finish)
-    .append(1, SEPARATOR)
+    .field(idle ? "" : ha_action_type::finish)
     // label1~
-    .append(idle ? "" : get_translation(translation_item::pause_))
-    .append(1, SEPARATOR)
+    .field(idle ? "" : get_translation(translation_item::pause_))
     // label2~
-    .append(get_translation(idle ? 
+    .field(get_translation(idle ?
       translation_item::start : translation_item::cancel))
-    .append(1, SEPARATOR)
     // label3
-    .append(idle ? "" : get_translation(translation_item::finish));
+    .field(idle ? "" : get_translation(translation_item::finish));
 }
 
 void NSPanelLovelace::render_climate_detail_update_(StatefulPageItem *item) {
@@ -1065,164 +1042,161 @@ void NSPanelLovelace::render_climate_detail_update_(StatefulPageItem *item) {
 void NSPanelLovelace::render_climate_detail_update_(Entity *entity, const std::string &uuid) {
   if(entity == nullptr) return;
 
-  uint16_t icon_colour = 64512U;
+  const char *icon_colour = ui_color::dark_orange;
   auto &state = entity->get_state();
   if (state == entity_state::auto_ ||
       state == entity_state::heat_cool) {
-    icon_colour = 1024U;
+    icon_colour = ui_color::dark_green;
   } else if (state == entity_state::off ||
       state == entity_state::fan_only) {
-    icon_colour = 35921U;
+    icon_colour = ui_color::muddy_grey;
   } else if (state == entity_state::cool) {
-    icon_colour = 11487U;
+    icon_colour = ui_color::cool_blue;
   } else if (state == entity_state::dry) {
-    icon_colour = 60897U;
+    icon_colour = ui_color::light_orange;
   }
 
-  this->command_buffer_
-    // entityUpdateDetail~
-    .assign("entityUpdateDetail").append(1, SEPARATOR);
-
+  command_writer writer(this->command_buffer_, "entityUpdateDetail");
   // entity_id~
   if (!uuid.empty())
-    this->command_buffer_.append("uuid.").append(uuid);
+    writer.uuid(uuid);
   else
-    this->command_buffer_.append(entity->get_entity_id());
-
-  this->command_buffer_.append(1, SEPARATOR)
+    writer.field(entity->get_entity_id());
+  writer
     // icon_id~
-    .append(CHAR8_CAST(get_icon(CLIMATE_ICON_MAP, entity->get_state())))
-    .append(1, SEPARATOR)
+    .field(get_icon(CLIMATE_ICON_MAP, entity->get_state()))
     // icon_color~
-    .append(std::to_string(icon_colour)).append(1, SEPARATOR);
+    .field(icon_colour);
 
-  std::vector<ha_attr_type> mode_types = {
-    ha_attr_type::preset_modes,
-    ha_attr_type::swing_modes,
-    ha_attr_type::fan_modes
-  };
+  // the list of modes and the attribute with the current mode
+  static constexpr std::array<std::pair<ha_attr_type, ha_attr_type>, 3> mode_types{{
+    {ha_attr_type::preset_modes, ha_attr_type::preset_mode},
+    {ha_attr_type::swing_modes, ha_attr_type::swing_mode},
+    {ha_attr_type::fan_modes, ha_attr_type::fan_mode},
+  }};
 
-  for (auto mt : mode_types) {
-    auto &supported_modes = entity->get_attribute(mt);
-    if (supported_modes.empty()) continue;
-    
-    std::string mode_res;
-    if (mt == ha_attr_type::preset_modes) {
-      mode_res.reserve(supported_modes.size());
-      size_t pos_start = std::string::npos, pos_end = pos_start;
-      do {
-        pos_end = supported_modes.find(',', pos_start + 1);
-        mode_res.append(
-          get_translation(
-            supported_modes.substr(pos_start + 1, pos_end - pos_start - 1)));
-        if (pos_end != std::string::npos) mode_res.append(1, '?');
-        pos_start = pos_end;
-      } while (pos_start != std::string::npos);
-    } else {
-      mode_res = supported_modes;
-      replace_all(mode_res, ',', '?');
-    }
-    std::string mode_type = to_string(mt);
-    mode_type.pop_back();
+  for (auto &mode : mode_types) {
+    // empty attributes aren't stored
+    if (!entity->has_attribute(mode.first)) continue;
+    auto &supported_modes = entity->get_attribute(mode.first);
 
-    this->command_buffer_
+    writer
       // heading~
-      .append(get_translation(mode_type)).append(1, SEPARATOR)
+      .field(get_translation(to_string(mode.second)))
       // mode~
-      .append(to_string(mt)).append(1, SEPARATOR)
+      .field(to_string(mode.first))
       // curr_mode~
-      .append(entity->get_attribute(to_ha_attr(mode_type))).append(1, SEPARATOR)
+      .field(entity->get_attribute(mode.second))
       // mode_res~ (mode names separated by '?')
-      .append(mode_res).append(1, SEPARATOR);
-  }
+      .field();
+    if (mode.first != ha_attr_type::preset_modes) {
+      writer.list(supported_modes);
+      continue;
+    }
+    size_t pos_start = 0, pos_end;
+    do {
+      pos_end = supported_modes.find(',', pos_start);
+      size_t length = (pos_end == std::string::npos
+        ? supported_modes.length() : pos_end) - pos_start;
+      auto translation = find_translation(
+        supported_modes.data() + pos_start, length);
+      if (translation != nullptr)
+        writer.append(translation);
+      else
+        writer.append(std::string_view(supported_modes).substr(pos_start, length));
+      if (pos_end != std::string::npos) writer.append_char('?');
+      pos_start = pos_end + 1;
+    } while (pos_end != std::string::npos);
+  }
+  writer.field();
 }
 
 // entityUpdateDetail2~{entity_id}~~{icon_color}~{ha_type}~{state}~{options}~
 void NSPanelLovelace::render_input_select_detail_update_(StatefulPageItem *item) {
   if(item == nullptr) return;
 
-  auto state = item->get_state();
-  std::string options;
-  if (item->is_type(entity_type::input_select) || 
-      item->is_type(entity_type::select)) {
-    options = item->get_attribute(ha_attr_type::options);
-  }
-  else if (item->is_type(entity_type::light)) {
-    options = item->get_attribute(ha_attr_type::effect_list);
-  }
-  else if (item->is_type(entity_type::media_player)) {
-    options = item->get_attribute(ha_attr_type::source_list);
-    state = item->get_attribute(ha_attr_type::source);
+  auto options_attr = ha_attr_type::unknown;
+  switch(item->get_type()) {
+    case entity_kind::input_select:
+    case entity_kind::select:
+      options_attr = ha_attr_type::options;
+      break;
+    case entity_kind::light:
+      options_attr = ha_attr_type::effect_list;
+      break;
+    case entity_kind::media_player:
+      options_attr = ha_attr_type::source_list;
+      break;
+    default:
+      break;
   }
-  if (!options.empty()) replace_all(options, ',', '?');
 
-  this->command_buffer_
-    // entityUpdateDetail2~
-    .assign("entityUpdateDetail2").append(1, SEPARATOR)
+  command_writer writer(this->command_buffer_, "entityUpdateDetail2");
+  writer
     // entity_id~~
-    .append("uuid.").append(item->get_uuid()).append(2, SEPARATOR)
+    .uuid(item->get_uuid()).field()
     // icon_color~
-    .append(item->get_icon_color_str()).append(1, SEPARATOR)
+    .field(item->get_icon_color_str())
     // ha_type~
-    .append(item->get_type()).append(1, SEPARATOR)
-    // state~
-    .append(state).append(1, SEPARATOR)
-    // options~
-    .append(options).append(1, SEPARATOR);
+    .field(item->get_type_str());
+  // state~
+  if (item->get_type() == entity_kind::media_player)
+    writer.field(item->get_attribute(ha_attr_type::source));
+  else
+    writer.field(item->get_state());
+  // options~
+  writer.field();
+  if (options_attr != ha_attr_type::unknown)
+    writer.list(item->get_attribute(options_attr));
+  writer.field();
 }
 
 // entityUpdateDetail~{entity_id}~~{icon_color}~{switch_val}~{speed}~{speed_max}~{speed_translation}~{preset_mode}~{preset_modes}
 void NSPanelLovelace::render_fan_detail_update_(StatefulPageItem *item) {
   if(item == nullptr) return;
 
-  auto speed = item->get_attribute(ha_attr_type::percentage);
-  auto percentage_step = item->get_attribute(ha_attr_type::percentage_step);
-  auto preset_mode = item->get_attribute(ha_attr_type::preset_mode);
-  auto preset_modes = item->get_attribute(ha_attr_type::preset_modes);
-  if (!preset_modes.empty()) replace_all(preset_modes, ',', '?');
-
+  bool speed_supported = item->get_entity()->has_attribute(
+    ha_attr_type::percentage_step);
+  uint16_t speed = 0;
   uint8_t speed_max = 100;
-  if (!percentage_step.empty()) {
-    float speed_val = 0.0f;
-    if (speed.empty()) {
-      speed = "0";
-    } else {
-      speed_val = std::stof(speed);
-    }
-    auto step_val = std::stof(percentage_step);
+  if (speed_supported) {
+    float speed_val = value_or_default(
+      item->get_attribute(ha_attr_type::percentage), 0.0);
+    float step_val = value_or_default(
+      item->get_attribute(ha_attr_type::percentage_step), 0.0);
     if (step_val < 1.0f) step_val = 1.0f; // avoid divide-by-zero
-    speed = esphome::to_string(
-      static_cast<uint16_t>(round(speed_val / step_val)));
+    speed = static_cast<uint16_t>(round(speed_val / step_val));
     speed_max = static_cast<uint16_t>(round(100.0f / step_val));
   }
 
-  this->command_buffer_
-    // entityUpdateDetail~
-    .assign("entityUpdateDetail").append(1, SEPARATOR)
+  command_writer writer(this->command_buffer_, "entityUpdateDetail");
+  writer
     // entity_id~~
-    .append("uuid.").append(item->get_uuid()).append(2, SEPARATOR)
+    .uuid(item->get_uuid()).field()
     // icon_color~
-    .append(item->get_icon_color_str()).append(1, SEPARATOR)
+    .field(item->get_icon_color_str())
     // switch_val~
-    .append(esphome::to_string(item->is_state(entity_state::on) ? 1 : 0))
-    .append(1, SEPARATOR)
-    // speed~
-    .append(percentage_step.empty() ? generic_type::disable : speed)
-    .append(1, SEPARATOR)
+    .bit(item->is_state(entity_state::on));
+  // speed~
+  if (speed_supported)
+    writer.field(speed);
+  else
+    writer.field(generic_type::disable);
+  writer
     // speed_max~
-    .append(esphome::to_string(speed_max)).append(1, SEPARATOR)
+    .field(speed_max)
     // speed_translation~
-    .append(get_translation(translation_item::speed)).append(1, SEPARATOR)
+    .field(get_translation(translation_item::speed))
     // preset_mode~
-    .append(preset_mode).append(1, SEPARATOR)
+    .field(item->get_attribute(ha_attr_type::preset_mode))
     // preset_modes
-    .append(preset_modes);
+    .field().list(item->get_attribute(ha_attr_type::preset_modes));
 }
 
 void NSPanelLovelace::dump_config() {
   ESP_LOGCONFIG(TAG, "NSPanelLovelace:");
   ESP_LOGCONFIG(TAG, "\tVersion: %s", NSPANEL_LOVELACE_BUILD_VERSION);
-  ESP_LOGCONFIG(TAG, "\tRAM: min_heap:%u psram_used:%zu int_min_free:%zu int_free:%zu int_max_free_blk:%zu",
+  ESP_LOGCONFIG(TAG, "\tRAM (whole heap): min_heap:%u psram_used:%zu int_min_free:%zu int_free:%zu int_max_free_blk:%zu",
     esp_get_minimum_free_heap_size(),
     psram_used(),
     heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
@@ -1232,6 +1206,54 @@ void NSPanelLovelace::dump_config() {
       this->pages_.size(),
       this->stateful_page_items_.size(),
       this->entities_.size());
+  ESP_LOGCONFIG(TAG, "\tHA subscriptions: count:%u heap:%zu",
+      this->subscription_count_, this->subscription_heap_used_);
+  if (this->defer_hidden_updates_) {
+    ESP_LOGCONFIG(TAG, "\tDeferred updates: skipped:%" PRIu32 " applied:%" PRIu32 " pending:%zu",
+        this->deferred_update_count_, this->deferred_flush_count_,
+        this->deferred_entities_.size());
+  }
+  ESP_LOGCONFIG(TAG, "\tControl presses coalesced: %" PRIu32,
+      this->control_coalesced_count_);
+  if (this->optimistic_updates_) {
+    ESP_LOGCONFIG(TAG, "\tOptimistic updates: confirmed:%" PRIu32 " corrected:%" PRIu32
+        " reverted:%" PRIu32 " pending:%zu",
+        this->optimistic_confirmed_count_, this->optimistic_corrected_count_,
+        this->optimistic_reverted_count_, this->optimistic_pending_.size());
+    ESP_LOGCONFIG(TAG, "\tOptimistic update latency: avg:%" PRIu32 "ms max:%" PRIu32 "ms",
+        this->optimistic_confirmed_count_ == 0 ? 0 :
+          this->optimistic_latency_total_ / this->optimistic_confirmed_count_,
+        this->optimistic_latency_max_);
+  }
+  size_t cached_pages = 0, cache_size = 0, cache_size_all = 0;
+  for (auto &page : this->pages_) {
+    if (page->has_render_cache()) {
+      cached_pages++;
+      cache_size += page->get_render_cache_size();
+    }
+    cache_size_all += page->get_render_length();
+  }
+  ESP_LOGCONFIG(TAG, "\tRender cache: pages:%zu/%zu cached_bytes:%zu (caching every page:%zu) in %s prerendered:%" PRIu32,
+      cached_pages, this->pages_.size(), cache_size, cache_size_all,
+      psram_available() ? "PSRAM" : "internal RAM", this->prerender_count_);
+#ifdef USE_NSPANEL_RENDER_STATS
+  // one line per kind of render, averages are per render
+  for (uint8_t i = 0; i < RENDER_STAT_COUNT; i++) {
+    const auto &stat = this->render_stats_[i];
+    if (stat.count == 0) continue;
+    ESP_LOGCONFIG(TAG, "\tRender stats: type:%s count:%" PRIu32 " avg_us:%" PRIu32
+        " max_us:%" PRIu32 " avg_bytes:%" PRIu32 " buffer_grows:%" PRIu32,
+        i == RENDER_STAT_STATUS_UPDATE ? "statusUpdate" :
+          i == RENDER_STAT_POPUP_DETAIL ? "popupDetail" :
+          to_string(static_cast<page_type>(i)),
+        stat.count, stat.time_us / stat.count, stat.max_time_us,
+        stat.bytes / stat.count, stat.buffer_grows);
+  }
+#endif
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+  ESP_LOGCONFIG(TAG, "\tState snapshot: size:%u interval:%" PRIu32 "ms",
+      STATE_SNAPSHOT_SIZE, this->state_snapshot_interval_);
+#endif
 }
 
 void NSPanelLovelace::send_nextion_command_(const std::string &command) {
@@ -1251,15 +1273,29 @@ void NSPanelLovelace::process_display_command_queue_() {
 
   // Store the command for later processing so the function can return quickly
   if (!this->command_buffer_.empty()) {
-    this->command_queue_.push(this->command_buffer_);
-    ESP_LOGVV(TAG, "Command queued (size: %u)", this->command_queue_.size());
+    // queued commands reuse the buffers of commands which have been sent,
+    // those keep their capacity so the copy doesn't need to allocate
+    std::string command;
+    if (!this->command_pool_.empty()) {
+      command.swap(this->command_pool_.back());
+      this->command_pool_.pop_back();
+    }
+    assign_exact(command, this->command_buffer_);
+    this->command_queue_.push(std::move(command));
+    ESP_LOGVV(TAG, "Command queued (size: %zu)", this->command_queue_.size());
     this->command_buffer_.clear();
     return;
   } else if (!this->command_queue_.empty()) {
-    // todo: can we use std::move? it changes the capacity of the buffer
-    this->command_buffer_.assign(this->command_queue_.front());
+    auto &sent = this->command_queue_.front();
+    // assigned rather than moved so command_buffer_ keeps its capacity
+    this->command_buffer_.assign(sent);
+    // the pool is capped, other buffers are freed when popped
+    if (this->command_pool_.size() < COMMAND_POOL_SIZE &&
+        sent.capacity() <= COMMAND_POOL_MAX_CAPACITY) {
+      this->command_pool_.push_back(std::move(sent));
+    }
     this->command_queue_.pop();
-    ESP_LOGVV(TAG, "Command un-queued (size: %u)", this->command_queue_.size());
+    ESP_LOGVV(TAG, "Command un-queued (size: %zu)", this->command_queue_.size());
   }
 
   ESP_LOGD(TAG, "TFT CMD OUT: %s", this->command_buffer_.c_str());
@@ -1634,6 +1670,72 @@ const std::string &NSPanelLovelace::try_replace_uuid_with_entity_id_(
   return item->get_entity_id();
 }
 
+void NSPanelLovelace::set_control_interval(control_type type, uint16_t interval_ms) {
+  if (type == control_type::unknown) return;
+  this->control_intervals_[static_cast<uint8_t>(type)] = interval_ms;
+}
+
+// Returns true when the button press should be processed now. The first press of
+// a slider is sent straight away, presses within the interval only keep the
+// latest value which process_pending_controls_ sends once the interval passes.
+bool NSPanelLovelace::coalesce_control_press_(
+    const std::string &internal_id,
+    const std::string &button_type,
+    const std::string &value) {
+  auto type = get_control_type(button_type);
+  if (type == control_type::unknown) return true;
+
+  const uint32_t now = millis();
+  const uint16_t interval = this->control_intervals_[static_cast<uint8_t>(type)];
+  for (auto &control : this->controls_) {
+    if (control.type != type || control.internal_id != internal_id) continue;
+    if (now - control.last_sent >= interval) {
+      // this press supersedes any pending value
+      control.pending = false;
+      control.value.clear();
+      control.last_sent = now;
+      return true;
+    }
+    control.pending = true;
+    control.value = value;
+    this->control_coalesced_count_++;
+    return false;
+  }
+
+  this->controls_.push_back({internal_id, type, false, now, std::string()});
+  return true;
+}
+
+void NSPanelLovelace::process_pending_controls_() {
+  if (this->controls_.empty()) return;
+
+  const uint32_t now = millis();
+  for (size_t i = 0; i < this->controls_.size();) {
+    auto &control = this->controls_[i];
+    if (now - control.last_sent < this->control_intervals_[static_cast<uint8_t>(control.type)]) {
+      i++;
+      continue;
+    }
+    // idle for a whole interval, the next press is sent straight away
+    if (!control.pending) {
+      this->controls_.erase(this->controls_.begin() + i);
+      continue;
+    }
+
+    control.pending = false;
+    control.last_sent = now;
+    // process_button_press_ replaces the uuid with the entity id
+    std::string internal_id = control.internal_id;
+    std::string value;
+    value.swap(control.value);
+    const char *button_type = to_button_type(control.type);
+    ESP_LOGD(TAG, "Button press delayed: %s,%s,%s",
+        internal_id.c_str(), button_type, value.c_str());
+    this->process_button_press_(internal_id, button_type, value, true);
+    i++;
+  }
+}
+
 void NSPanelLovelace::process_button_press_(
     std::string &internal_id, 
     const std::string &button_type, 
@@ -1642,38 +1744,19 @@ void NSPanelLovelace::process_button_press_(
   if (button_type.empty()) return;
   
   // Throttle and filter processing of spammy actions to avoid command flooding
-  if (!called_from_timeout) {
-    if (internal_id == this->button_press_uuid_ && 
-        button_type == this->button_press_type_) {
-      this->button_press_value_ = value;
-      if (this->button_press_timeout_set_) return;
-      this->set_timeout("btnpr", 200, [this]() {
-        this->button_press_timeout_set_ = false;
-        ESP_LOGD(TAG, "Button press delayed: %s,%s,%s", 
-            this->button_press_uuid_.c_str(), this->button_press_type_.c_str(), 
-            this->button_press_value_.c_str());
-        this->process_button_press_(
-            this->button_press_uuid_, this->button_press_type_, 
-            this->button_press_value_, true);
-      });
-      this->button_press_timeout_set_ = true;
-      return;
-    } else if (this->button_press_timeout_set_) {
-      this->cancel_timeout("btnpr");
-      this->button_press_timeout_set_ = false;
-    }
-    this->button_press_uuid_ = internal_id;
-    this->button_press_type_ = button_type;
+  if (!called_from_timeout &&
+      !this->coalesce_control_press_(internal_id, button_type, value)) {
+    return;
   }
 
-  auto entity_type = get_entity_type(internal_id);
+  auto kind = get_entity_type(internal_id);
   std::string& entity_id = internal_id;
   
-  if (entity_type == entity_type::uuid) {
+  if (kind == entity_kind::uuid) {
     entity_id = this->try_replace_uuid_with_entity_id_(internal_id);
     ESP_LOGV(TAG, "Lookup %s -> %s", internal_id.c_str(), entity_id.c_str());
-    entity_type = get_entity_type(entity_id);
-    if (entity_type == nullptr) return;
+    kind = get_entity_type(entity_id);
+    if (kind == entity_kind::unknown) return;
   }
 
   // Screen tapped when on the screensaver, show the default card or use the first card in the config.
@@ -1710,14 +1793,16 @@ void NSPanelLovelace::process_button_press_(
   if (button_type == button_type::onOff) {
     if (!value.empty()) {
       this->call_ha_service_(
-        entity_type, 
+        kind, 
         value == "1" ? ha_action_type::turn_on : ha_action_type::turn_off, 
         entity_id);
+      this->apply_optimistic_update_(entity_id, ha_attr_type::state,
+        value == "1" ? entity_state::on : entity_state::off);
     }
   } 
   // fan, number, input_number
   else if (button_type == button_type::numberSet) {
-    if (entity_type == entity_type::fan) {
+    if (kind == entity_kind::fan) {
       auto entity = this->get_entity_(entity_id);
       if (entity == nullptr) return;
       auto step = std::stof(
@@ -1728,116 +1813,139 @@ void NSPanelLovelace::process_button_press_(
       auto pct = esphome::str_snprintf("%.6f", 11, val);
       
       this->call_ha_service_(
-        entity_type, 
+        kind, 
         ha_action_type::set_percentage, 
-        {{
-          {to_string(ha_attr_type::entity_id), entity_id},
-          {to_string(ha_attr_type::percentage), pct}
-        }});
+        {
+          {ha_attr_type::entity_id, entity_id},
+          {ha_attr_type::percentage, pct}
+        });
     } else {
       this->call_ha_service_(
-        entity_type, 
+        kind, 
         ha_action_type::set_value, 
-        {{
-          {to_string(ha_attr_type::entity_id), entity_id},
-          {to_string(ha_attr_type::value), value}
-        }});
+        {
+          {ha_attr_type::entity_id, entity_id},
+          {ha_attr_type::value, value}
+        });
+      // the slider sends whole numbers, Home Assistant reports them as "42.0"
+      std::string expected(value);
+      if (expected.find('.') == std::string::npos) expected.append(".0");
+      this->apply_optimistic_update_(entity_id, ha_attr_type::state, expected);
     }
   }
   // cover and shutter cards
   else if (button_type == button_type::up) {
     this->call_ha_service_(
-      entity_type, ha_action_type::open_cover, entity_id);
+      kind, ha_action_type::open_cover, entity_id);
   } else if (button_type == button_type::stop) {
     this->call_ha_service_(
-      entity_type, ha_action_type::stop_cover, entity_id);
+      kind, ha_action_type::stop_cover, entity_id);
   } else if (button_type == button_type::down) {
     this->call_ha_service_(
-      entity_type, ha_action_type::close_cover, entity_id);
+      kind, ha_action_type::close_cover, entity_id);
   } else if (button_type == button_type::positionSlider) {
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_cover_position, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::position), value}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::position, value}
+      });
+    this->apply_optimistic_update_(entity_id, ha_attr_type::current_position, value);
   } else if (button_type == button_type::tiltOpen) {
     this->call_ha_service_(
-      entity_type, ha_action_type::open_cover_tilt, entity_id);
+      kind, ha_action_type::open_cover_tilt, entity_id);
   } else if (button_type == button_type::tiltStop) {
     this->call_ha_service_(
-      entity_type, ha_action_type::stop_cover_tilt, entity_id);
+      kind, ha_action_type::stop_cover_tilt, entity_id);
   } else if (button_type == button_type::tiltClose) {
     this->call_ha_service_(
-      entity_type, ha_action_type::close_cover_tilt, entity_id);
+      kind, ha_action_type::close_cover_tilt, entity_id);
   } else if (button_type == button_type::tiltSlider) {
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_cover_tilt_position, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::tilt_position), value}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::tilt_position, value}
+      });
+    this->apply_optimistic_update_(entity_id, ha_attr_type::current_tilt_position, value);
   } else if (button_type == button_type::button) {
-    if (entity_type == entity_type::navigate ||
-        entity_type == entity_type::navigate_uuid) {
-      auto uuid = internal_id.substr(strlen(entity_type) + 1);
-      this->render_page_(this->find_page_index_by_uuid_(uuid));
-    } else if (
-        entity_type == entity_type::scene ||
-        entity_type == entity_type::script) {
-      this->call_ha_service_(
-        entity_type, ha_action_type::turn_on, entity_id);
-    } else if (
-        entity_type == entity_type::light ||
-        entity_type == entity_type::switch_ ||
-        entity_type == entity_type::input_boolean ||
-        entity_type == entity_type::automation ||
-        entity_type == entity_type::fan) {
-      this->call_ha_service_(
-        entity_type, ha_action_type::toggle, entity_id);
-    } else if (
-        entity_type == entity_type::button ||
-        entity_type == entity_type::input_button) {
-      this->call_ha_service_(
-        entity_type, ha_action_type::press, entity_id);
-    } else if (entity_type == entity_type::input_select) {
-      this->call_ha_service_(
-        entity_type, ha_action_type::select_next, entity_id);
-    } else if (entity_type == entity_type::vacuum) {
-      auto entity = this->get_entity_(entity_id);
-      if (entity == nullptr) return;
-      this->call_ha_service_(entity_type,
-        entity->is_state(entity_state::docked) 
-          ? ha_action_type::start 
-          : ha_action_type::return_to_base,
-        entity_id);
-    } else if (entity_type == entity_type::lock) {
-      auto entity = this->get_entity_(entity_id);
-      if (entity == nullptr) return;
-      this->call_ha_service_(entity_type,
-        entity->is_state(entity_state::locked) 
-          ? ha_action_type::unlock 
-          : ha_action_type::lock,
-        entity_id);
+    switch(kind) {
+      case entity_kind::navigate:
+      case entity_kind::navigate_uuid: {
+        auto uuid = internal_id.substr(strlen(to_string(kind)) + 1);
+        this->render_page_(this->find_page_index_by_uuid_(uuid));
+        break;
+      }
+      case entity_kind::scene:
+      case entity_kind::script:
+        this->call_ha_service_(
+          kind, ha_action_type::turn_on, entity_id);
+        break;
+      case entity_kind::light:
+      case entity_kind::switch_:
+      case entity_kind::input_boolean:
+      case entity_kind::automation:
+      case entity_kind::fan: {
+        this->call_ha_service_(
+          kind, ha_action_type::toggle, entity_id);
+        auto entity = this->get_entity_(entity_id);
+        if (entity == nullptr) return;
+        if (entity->is_state(entity_state::on) || entity->is_state(entity_state::off)) {
+          this->apply_optimistic_update_(entity_id, ha_attr_type::state,
+            entity->is_state(entity_state::on) ? entity_state::off : entity_state::on);
+        }
+        break;
+      }
+      case entity_kind::button:
+      case entity_kind::input_button:
+        this->call_ha_service_(
+          kind, ha_action_type::press, entity_id);
+        break;
+      case entity_kind::input_select:
+        this->call_ha_service_(
+          kind, ha_action_type::select_next, entity_id);
+        break;
+      case entity_kind::vacuum: {
+        auto entity = this->get_entity_(entity_id);
+        if (entity == nullptr) return;
+        this->call_ha_service_(kind,
+          entity->is_state(entity_state::docked) 
+            ? ha_action_type::start 
+            : ha_action_type::return_to_base,
+          entity_id);
+        break;
+      }
+      case entity_kind::lock: {
+        auto entity = this->get_entity_(entity_id);
+        if (entity == nullptr) return;
+        this->call_ha_service_(kind,
+          entity->is_state(entity_state::locked) 
+            ? ha_action_type::unlock 
+            : ha_action_type::lock,
+          entity_id);
+        break;
+      }
+      default:
+        break;
     }
   }
   // media cards
   else if (button_type == button_type::mediaNext) {
     this->call_ha_service_(
-      entity_type, ha_action_type::media_next_track, entity_id);
+      kind, ha_action_type::media_next_track, entity_id);
   } else if (button_type == button_type::mediaBack) {
     this->call_ha_service_(
-      entity_type, ha_action_type::media_previous_track, entity_id);
+      kind, ha_action_type::media_previous_track, entity_id);
   } else if (button_type == button_type::mediaPause) {
     this->call_ha_service_(
-      entity_type, ha_action_type::media_play_pause, entity_id);
+      kind, ha_action_type::media_play_pause, entity_id);
   } else if (button_type == button_type::mediaOnOff) {
     auto entity = this->get_entity_(entity_id);
     if (entity == nullptr) return;
     this->call_ha_service_(
-      entity_type,
+      kind,
       entity->is_state(entity_state::on) 
         ? ha_action_type::turn_off 
         : ha_action_type::turn_on,
@@ -1850,29 +1958,29 @@ void NSPanelLovelace::process_button_press_(
     shuffle = shuffle == entity_state::off 
       ? entity_state::on : entity_state::off;
     this->call_ha_service_(
-      entity_type,
+      kind,
       ha_action_type::shuffle_set,
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::shuffle), shuffle}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::shuffle, shuffle}
+      });
   } else if (button_type == button_type::volumeSlider) {
     auto volume = esphome::str_snprintf("%.2f", 7, std::stoi(value) * 0.01f);
     this->call_ha_service_(
-      entity_type,
+      kind,
       ha_action_type::volume_set,
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::volume_level), volume}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::volume_level, volume}
+      });
   } else if (button_type == button_type::speakerSel) {
     this->call_ha_service_(
-      entity_type,
+      kind,
       ha_action_type::select_source,
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::source), value}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::source, value}
+      });
   } else if (button_type == button_type::modeMediaPlayer) {
     auto entity = this->get_entity_(entity_id);
     if (entity == nullptr) return;
@@ -1883,27 +1991,29 @@ void NSPanelLovelace::process_button_press_(
     uint8_t index = stoi(value);
     if (source_list.size() <= index) return;
     this->call_ha_service_(
-      entity_type,
+      kind,
       ha_action_type::select_source,
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::source), source_list.at(index)}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::source, source_list.at(index)}
+      });
   }
   // light cards
   else if (button_type == button_type::brightnessSlider) {
     if (value.empty()) return;
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::turn_on, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
+      {
+        {ha_attr_type::entity_id, entity_id},
         // scale 0-100 to ha brightness range
-        {to_string(ha_attr_type::brightness), std::to_string(
+        {ha_attr_type::brightness, std::to_string(
           static_cast<int>(
             scale_value(std::stoi(value), {0, 100}, {0, 255})
           ))}
-      }});
+      });
+    // brightness is stored in the 0-100 range of the slider
+    this->apply_optimistic_update_(entity_id, ha_attr_type::brightness, value);
   } else if (button_type == button_type::colorTempSlider) {
     if (value.empty()) return;
     auto entity = this->get_entity_(entity_id);
@@ -1919,17 +2029,17 @@ void NSPanelLovelace::process_button_press_(
     }
     
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::turn_on, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
+      {
+        {ha_attr_type::entity_id, entity_id},
         // scale 0-100 from slider to color range of the light
-        {to_string(ha_attr_type::color_temp), std::to_string(
+        {ha_attr_type::color_temp, std::to_string(
           static_cast<int>(
             scale_value(std::stoi(value), {0, 100},
             {static_cast<double>(min_mireds), static_cast<double>(max_mireds)})
           ))}
-      }});
+      });
   } else if (button_type == button_type::colorWheel) {
     if (value.empty()) return;
 
@@ -1945,25 +2055,25 @@ void NSPanelLovelace::process_button_press_(
         ), ',', '[', ']');
 
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::turn_on, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id}
-      }},
-      {{
-        {to_string(ha_attr_type::rgb_color), rgb_str}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id}
+      },
+      {
+        {ha_attr_type::rgb_color, rgb_str}
+      });
   }
   // thermo/climate card
   else if (button_type == button_type::tempUpd) {
     auto val = esphome::str_snprintf("%.1f", 6, std::stoi(value) * 0.1);
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_temperature, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::temperature), val}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::temperature, val}
+      });
   } else if (button_type == button_type::tempUpdHighLow) {
     std::vector<std::string> temp_values;
     split_str('|', value, temp_values);
@@ -1972,21 +2082,21 @@ void NSPanelLovelace::process_button_press_(
     auto temp_low = esphome::str_snprintf(
       "%.1f", 6, std::stoi(temp_values[1]) * 0.1);
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_temperature, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::target_temp_high), temp_high},
-        {to_string(ha_attr_type::target_temp_low), temp_low}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::target_temp_high, temp_high},
+        {ha_attr_type::target_temp_low, temp_low}
+      });
   } else if (button_type == button_type::hvacAction) {
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_hvac_mode, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::hvac_mode), value}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::hvac_mode, value}
+      });
   } else if (button_type == button_type::modePresetModes) {
     auto entity = this->get_entity_(entity_id);
     if (entity == nullptr) return;
@@ -1996,12 +2106,12 @@ void NSPanelLovelace::process_button_press_(
     split_str(',', modes_str, modes);
     auto &selected_mode = modes.at(std::stoi(value));
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_preset_mode, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::preset_mode), selected_mode}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::preset_mode, selected_mode}
+      });
   } else if (button_type == button_type::modeSwingModes) {
     auto entity = this->get_entity_(entity_id);
     if (entity == nullptr) return;
@@ -2011,12 +2121,12 @@ void NSPanelLovelace::process_button_press_(
     split_str(',', modes_str, modes);
     auto &selected_mode = modes.at(std::stoi(value));
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_swing_mode, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::swing_mode), selected_mode}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::swing_mode, selected_mode}
+      });
   } else if (button_type == button_type::modeFanModes) {
     auto entity = this->get_entity_(entity_id);
     if (entity == nullptr) return;
@@ -2026,12 +2136,12 @@ void NSPanelLovelace::process_button_press_(
     split_str(',', modes_str, modes);
     auto &selected_mode = modes.at(std::stoi(value));
     this->call_ha_service_(
-      entity_type, 
+      kind, 
       ha_action_type::set_fan_mode, 
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::fan_mode), selected_mode}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::fan_mode, selected_mode}
+      });
   }
   // alarm card
   else if (
@@ -2042,14 +2152,14 @@ void NSPanelLovelace::process_button_press_(
       button_type == button_type::disarm) {
     auto action = std::string("alarm_").append(button_type);
     if (value.empty()) {
-      this->call_ha_service_(entity_type, action.c_str(), entity_id);
+      this->call_ha_service_(kind, action.c_str(), entity_id);
     } else {
       this->call_ha_service_(
-        entity_type, action.c_str(), 
-        {{
-          {to_string(ha_attr_type::entity_id), entity_id},
-          {to_string(ha_attr_type::code), value}
-        }});
+        kind, action.c_str(), 
+        {
+          {ha_attr_type::entity_id, entity_id},
+          {ha_attr_type::code, value}
+        });
     }
   } else if (button_type == button_type::opnSensorNotify) {
     auto entity = this->get_entity_(entity_id);
@@ -2084,12 +2194,13 @@ void NSPanelLovelace::process_button_press_(
     uint8_t index = stoi(value);
     if (options.size() <= index) return;
     this->call_ha_service_(
-      entity_type,
+      kind,
       ha_action_type::select_option,
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::option), options.at(index)}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::option, options.at(index)}
+      });
+    this->apply_optimistic_update_(entity_id, ha_attr_type::state, options.at(index));
   }
   // light
   else if (button_type == button_type::modeLight) {
@@ -2102,25 +2213,25 @@ void NSPanelLovelace::process_button_press_(
     uint8_t index = stoi(value);
     if (effects.size() <= index) return;
     this->call_ha_service_(
-      entity_type,
+      kind,
       ha_action_type::turn_on,
-      {{
-        {to_string(ha_attr_type::entity_id), entity_id},
-        {to_string(ha_attr_type::effect), effects.at(index)}
-      }});
+      {
+        {ha_attr_type::entity_id, entity_id},
+        {ha_attr_type::effect, effects.at(index)}
+      });
   }
   // timer card
   else if (esphome::str_startswith(button_type, entity_type::timer)) {
     std::string service(button_type);
     service[5] = '.';
     if (value.empty()) {
-      this->call_ha_service_(service, entity_id);
+      this->call_ha_service_(service.c_str(), entity_id);
     } else {
-      this->call_ha_service_(service, 
-        {{
-          {to_string(ha_attr_type::entity_id), entity_id},
-          {to_string(ha_attr_type::duration), value}
-        }});
+      this->call_ha_service_(service.c_str(),
+        {
+          {ha_attr_type::entity_id, entity_id},
+          {ha_attr_type::duration, value}
+        });
     }
   }
 }
@@ -2152,138 +2263,375 @@ Entity* NSPanelLovelace::get_entity_(const std::string &entity_id) {
 }
 
 void NSPanelLovelace::call_ha_service_(
-    const std::string &service, const std::string &entity_id) {
-  this->call_ha_service_(service, {{to_string(ha_attr_type::entity_id), entity_id}});
+    const char *service, const std::string &entity_id) {
+  this->call_ha_service_(service, {{ha_attr_type::entity_id, entity_id}});
 }
 
 void NSPanelLovelace::call_ha_service_(
-    const char *entity_type, const std::string &action, const std::string &entity_id) {
-  this->call_ha_service_(entity_type, action, {{to_string(ha_attr_type::entity_id), entity_id}});
+    entity_kind kind, const char *action, const std::string &entity_id) {
+  this->call_ha_service_(kind, action, {{ha_attr_type::entity_id, entity_id}});
 }
 
 void NSPanelLovelace::call_ha_service_(
-    const char *entity_type, const std::string &action,
-    const std::map<std::string, std::string> &data,
-    const std::map<std::string, std::string> &data_template) {
-  this->call_ha_service_(
-    std::string(entity_type).append(1, '.').append(action),
-    data, data_template);
+    entity_kind kind, const char *action,
+    std::initializer_list<ha_service_data> data,
+    std::initializer_list<ha_service_data> data_template) {
+  // assigning keeps the buffer from the previous call
+  this->service_call_.service.assign(to_string(kind)).append(1, '.').append(action);
+  this->send_ha_service_call_(data, data_template);
 }
 
 void NSPanelLovelace::call_ha_service_(
-    const std::string &service,
-    const std::map<std::string, std::string> &data,
-    const std::map<std::string, std::string> &data_template) {
-  api::HomeassistantServiceResponse resp;
-  resp.service = service;
-
-  auto it = data.find(to_string(ha_attr_type::entity_id));
-  if (it == data.end())
-    ESP_LOGD(TAG, "Call HA: %s -> %s", resp.service.c_str(), it->second.c_str());
-  else
-    ESP_LOGD(TAG, "Call HA: %s", resp.service.c_str());
+    const char *service,
+    std::initializer_list<ha_service_data> data,
+    std::initializer_list<ha_service_data> data_template) {
+  this->service_call_.service.assign(service);
+  this->send_ha_service_call_(data, data_template);
+}
 
-  for (auto &it : data) {
-    api::HomeassistantServiceMap kv;
-    kv.key = it.first;
-    kv.value = it.second;
-    resp.data.push_back(kv);
+static void assign_service_data(
+    std::vector<api::HomeassistantServiceMap> &target,
+    std::initializer_list<ha_service_data> data) {
+  // existing entries are reused, so after the first few calls
+  // the keys and values fit in the strings which are already allocated
+  target.resize(data.size());
+  auto kv = target.begin();
+  for (auto &item : data) {
+    kv->key.assign(to_string(item.key));
+    kv->value.assign(item.value);
+    ++kv;
   }
-  for (auto &it : data_template) {
-    api::HomeassistantServiceMap kv;
-    kv.key = it.first;
-    kv.value = it.second;
-    resp.data_template.push_back(kv);
+}
+
+void NSPanelLovelace::send_ha_service_call_(
+    std::initializer_list<ha_service_data> data,
+    std::initializer_list<ha_service_data> data_template) {
+  auto &call = this->service_call_;
+  assign_service_data(call.data, data);
+  assign_service_data(call.data_template, data_template);
+
+  const std::string *entity_id = nullptr;
+  for (auto &item : data) {
+    if (item.key == ha_attr_type::entity_id) {
+      entity_id = &item.value;
+      break;
+    }
   }
+  if (entity_id != nullptr)
+    ESP_LOGD(TAG, "Call HA: %s -> %s", call.service.c_str(), entity_id->c_str());
+  else
+    ESP_LOGD(TAG, "Call HA: %s", call.service.c_str());
+
+  api::global_api_server->send_homeassistant_service_call(call);
+}
 
-  api::global_api_server->send_homeassistant_service_call(resp);
+void NSPanelLovelace::subscribe_entity_(uint16_t entity_index, ha_attr_type attr) {
+  auto &entity_id = this->entities_.at(entity_index)->get_entity_id();
+  entity_subscription_record record{entity_index, attr};
+  // Only a pointer and the record are captured so std::function can store
+  // the closure inline rather than allocating it on the heap
+  auto f = [this, record](std::string value) {
+    this->on_entity_subscription_update_(record, std::move(value));
+  };
+  static_assert(sizeof(f) <= 2 * sizeof(void *),
+    "subscription closure too large for std::function's inline storage");
+  api::global_api_server->subscribe_home_assistant_state(entity_id,
+    attr == ha_attr_type::state
+      ? optional<std::string>() : optional<std::string>(to_string(attr)),
+    f);
 }
 
-void NSPanelLovelace::on_entity_state_update_(std::string entity_id, std::string state) {
-  this->on_entity_attribute_update_(entity_id, to_string(ha_attr_type::state), state);
+void NSPanelLovelace::on_entity_subscription_update_(
+    entity_subscription_record record, std::string value) {
+  this->on_entity_attribute_update_(
+    record.entity_index, record.attr, std::move(value));
 }
-void NSPanelLovelace::on_entity_attribute_update_(std::string entity_id, std::string attr, std::string attr_value) {
-  auto entity = this->get_entity_(entity_id);
-  if (entity == nullptr) return;
-  auto ha_attr = to_ha_attr(attr);
-  if (ha_attr == ha_attr_type::unknown) return;
 
-  if (ha_attr == ha_attr_type::state) {
-    entity->set_state(attr_value);
+void NSPanelLovelace::on_entity_attribute_update_(uint16_t entity_index, ha_attr_type attr, std::string attr_value) {
+  if (entity_index >= this->entities_.size()) return;
+  if (attr == ha_attr_type::unknown) return;
+  auto entity = this->entities_[entity_index].get();
+  auto &entity_id = entity->get_entity_id();
+
+  // the value is moved all the way from the API callback into the entity
+  if (attr == ha_attr_type::state) {
+    entity->set_state(std::move(attr_value));
   } else {
-    entity->set_attribute(ha_attr, attr_value);
+    entity->set_attribute(attr, std::move(attr_value));
+  }
+  if (!this->optimistic_pending_.empty()) {
+    this->reconcile_optimistic_update_(entity_index, attr);
   }
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+  this->state_snapshot_dirty_ = true;
+#endif
 
   ESP_LOGD(TAG, "HA update: %s %s='%s'",
-    entity_id.c_str(), attr.c_str(), 
-    ha_attr == ha_attr_type::state
+    entity_id.c_str(), to_string(attr), 
+    attr == ha_attr_type::state
       ? entity->get_state().c_str()
-      : entity->get_attribute(ha_attr).c_str());
-
-  // if (this->force_current_page_update_) return;
+      : entity->get_attribute(attr).c_str());
 
   // If there are lots of entity attributes that update within a short time
-  // then this will queue lots of commands unnecessarily.
-  // This re-schedules updates every time one happens within a 200ms period.
-  this->set_timeout(entity_id, 200, [this, entity_id] () {
-    if (this->force_current_page_update_) return;
-    if (this->current_page_ == nullptr) return;
-
-    if (this->screensaver_ != nullptr && 
-        this->current_page_->is_type(page_type::screensaver)) {
-      force_current_page_update_ = 
-        this->screensaver_->should_render_status_update(entity_id);
-      return;
+  // then this would queue lots of commands unnecessarily, so changes are
+  // collected and all dirty entities are flushed together from loop().
+  this->mark_entity_dirty_(entity_index);
+}
+
+// Shows the expected result of an action before Home Assistant sends the new
+// value, the entity is re-rendered straight away rather than after the flush delay
+void NSPanelLovelace::apply_optimistic_update_(
+    const std::string &entity_id, ha_attr_type attr, const std::string &value) {
+  if (!this->optimistic_updates_ || value.empty()) return;
+  auto entity = this->get_entity_(entity_id);
+  if (entity == nullptr) return;
+  auto entity_index = this->find_entity_index_(entity);
+  if (entity_index >= this->entities_.size()) return;
+
+  // copied, the default value returned for a missing attribute is a temporary
+  std::string current = attr == ha_attr_type::state
+    ? entity->get_state() : entity->get_attribute(attr);
+  if (current == value) return;
+
+  auto it = std::find_if(
+    this->optimistic_pending_.begin(), this->optimistic_pending_.end(),
+    [entity_index, attr](const optimistic_update &update) {
+      return update.entity_index == entity_index && update.attr == attr;
+    });
+  if (it == this->optimistic_pending_.end()) {
+    this->optimistic_pending_.push_back({entity_index, attr, millis(), std::move(current), value});
+  } else {
+    // keep the confirmed value from the first update for reverting
+    it->started = millis();
+    it->expected = value;
+  }
+
+  ESP_LOGD(TAG, "Optimistic update: %s %s='%s'",
+    entity_id.c_str(), to_string(attr), value.c_str());
+  entity->restore_attribute(attr, value);
+  // Only this entity is flushed, other dirty entities keep waiting for
+  // the shared flush deadline
+  if (this->entity_dirty_[entity_index]) {
+    this->entity_dirty_[entity_index] = false;
+    auto &dirty = this->dirty_entities_;
+    dirty.erase(std::remove(dirty.begin(), dirty.end(), entity_index), dirty.end());
+  }
+  entity->flush_changes();
+  this->force_current_page_update_ = true;
+}
+
+// Called after Home Assistant has sent a new value, the received value
+// always replaces the optimistic one
+void NSPanelLovelace::reconcile_optimistic_update_(uint16_t entity_index, ha_attr_type attr) {
+  auto it = std::find_if(
+    this->optimistic_pending_.begin(), this->optimistic_pending_.end(),
+    [entity_index, attr](const optimistic_update &update) {
+      return update.entity_index == entity_index && update.attr == attr;
+    });
+  if (it == this->optimistic_pending_.end()) return;
+
+  auto entity = this->entities_[entity_index].get();
+  // numbers may be formatted differently than expected, e.g. "42" and "42.0"
+  bool confirmed = attr == ha_attr_type::state
+    ? entity->is_state(it->expected) ||
+      is_same_number(entity->get_state(), it->expected)
+    : entity->get_attribute(attr) == it->expected ||
+      is_same_number(entity->get_attribute(attr), it->expected);
+  uint32_t latency = millis() - it->started;
+  if (confirmed) {
+    this->optimistic_confirmed_count_++;
+    this->optimistic_latency_total_ += latency;
+    this->optimistic_latency_max_ = std::max(this->optimistic_latency_max_, latency);
+  } else {
+    this->optimistic_corrected_count_++;
+  }
+  ESP_LOGD(TAG, "Optimistic update %s after %" PRIu32 "ms: %s %s",
+    confirmed ? "confirmed" : "corrected", latency,
+    entity->get_entity_id().c_str(), to_string(attr));
+  this->optimistic_pending_.erase(it);
+}
+
+void NSPanelLovelace::expire_optimistic_updates_() {
+  if (this->optimistic_pending_.empty()) return;
+
+  const uint32_t now = millis();
+  auto it = this->optimistic_pending_.begin();
+  while (it != this->optimistic_pending_.end()) {
+    if (now - it->started < OPTIMISTIC_UPDATE_TIMEOUT) {
+      ++it;
+      continue;
     }
+    auto entity = this->entities_[it->entity_index].get();
+    ESP_LOGW(TAG, "Optimistic update not confirmed, reverting %s %s='%s'",
+      entity->get_entity_id().c_str(), to_string(it->attr), it->previous.c_str());
+    if (it->attr != ha_attr_type::state && it->previous.empty()) {
+      // the attribute didn't exist before, an empty value removes it
+      entity->set_attribute(it->attr, it->previous);
+    } else {
+      entity->restore_attribute(it->attr, it->previous);
+    }
+    this->mark_entity_dirty_(it->entity_index);
+    this->optimistic_reverted_count_++;
+    it = this->optimistic_pending_.erase(it);
+  }
+}
 
-    // re-render only if the entity is on the currently active card
-    // todo: this doesnt account for popup pages
-    for (auto &item : this->current_page_->get_items()) {
+void NSPanelLovelace::mark_entity_dirty_(uint16_t entity_index) {
+  if (!this->entity_dirty_[entity_index]) {
+    this->entity_dirty_[entity_index] = true;
+    this->dirty_entities_.push_back(entity_index);
+  }
+
+  uint32_t now = millis();
+  // the first change arms the flush
+  if (this->flush_delay_ == 0) {
+    this->flush_started_ = now;
+  }
+  // Every update pushes the flush back, but never further than
+  // ENTITY_FLUSH_MAX_DELAY after the first change
+  this->flush_delay_ = std::min<uint32_t>(
+    (now - this->flush_started_) + ENTITY_FLUSH_DELAY, ENTITY_FLUSH_MAX_DELAY);
+}
+
+void NSPanelLovelace::flush_dirty_entities_() {
+  bool render = false;
+  for (auto entity_index : this->dirty_entities_) {
+    this->entity_dirty_[entity_index] = false;
+    auto entity = this->entities_[entity_index].get();
+    if (!this->entity_visible_[entity_index]) {
+      // Nothing shows the entity, the subscribers will be notified
+      // when a page which shows it gets rendered
+      if (this->defer_hidden_updates_) {
+        this->defer_entity_changes_(entity_index);
+      } else {
+        entity->flush_changes();
+      }
+      continue;
+    }
+    // subscribers are notified once for all the changes within this period
+    entity->flush_changes();
+    // an open popup covers the page, so only its own entity needs rendering
+    render |= this->popup_page_current_uuid_.empty() ||
+      this->is_popup_item_of_(entity_index, this->cached_page_item_);
+  }
+  this->dirty_entities_.clear();
+  this->flush_delay_ = 0;
+
+  // a single re-render for all entities which changed together
+  if (render) {
+    this->force_current_page_update_ = true;
+  }
+}
+
+// Builds the reverse index of entity -> pages and popup items,
+// this must be called once all pages have been configured
+void NSPanelLovelace::build_entity_references_() {
+  this->entity_references_.assign(this->entities_.size(), {});
+  this->entity_visible_.assign(this->entities_.size(), false);
+
+  auto add_page = [this](const Entity *entity, size_t index) {
+    auto entity_index = this->find_entity_index_(entity);
+    if (entity_index >= this->entities_.size()) return;
+    auto &pages = this->entity_references_[entity_index].pages;
+    const auto page_index = static_cast<uint8_t>(index);
+    if (std::find(pages.begin(), pages.end(), page_index) == pages.end()) {
+      pages.push_back(page_index);
+    }
+  };
+
+  if (this->pages_.size() > MAX_PAGES) {
+    ESP_LOGE(TAG, "Too many pages (%zu), only the first %zu are updated",
+        this->pages_.size(), MAX_PAGES);
+  }
+  const size_t page_count = std::min(this->pages_.size(), MAX_PAGES);
+  for (size_t i = 0; i < page_count; i++) {
+    auto page = this->pages_[i].get();
+    for (auto &item : page->get_items()) {
       auto stateful_item = page_item_cast<StatefulPageItem>(item.get());
       if (stateful_item == nullptr) continue;
-      
-      if (stateful_item->get_entity_id() == entity_id) {
-        force_current_page_update_ = true;
-        return;
+      add_page(stateful_item->get_entity(), i);
+      auto entity_index = this->find_entity_index_(stateful_item->get_entity());
+      if (entity_index < this->entities_.size()) {
+        this->entity_references_[entity_index].popup_items.push_back(stateful_item);
       }
     }
 
-    auto entity_type = get_entity_type(entity_id);
-    // Thermo cards don't have items to check, only a single thermo entity
-    // render updates when climate entitites are updated
-    if (entity_type == entity_type::climate &&
-        this->current_page_->is_type(page_type::cardThermo)) {
-      force_current_page_update_ = true;
-      return;
-    }
-    else if (entity_type == entity_type::media_player &&
-        this->current_page_->is_type(page_type::cardMedia)) {
-      force_current_page_update_ = true;
-      return;
+    // Screensaver status icons and the main entity of alarm, thermo and
+    // media cards are not part of the page items
+    if (auto screensaver = page_cast<Screensaver>(page)) {
+      if (screensaver->get_icon_left() != nullptr)
+        add_page(screensaver->get_icon_left()->get_entity(), i);
+      if (screensaver->get_icon_right() != nullptr)
+        add_page(screensaver->get_icon_right()->get_entity(), i);
+    } else if (auto alarm_card = page_cast<AlarmCard>(page)) {
+      add_page(alarm_card->get_alarm_entity(), i);
+    } else if (auto thermo_card = page_cast<ThermoCard>(page)) {
+      add_page(thermo_card->get_thermo_entity(), i);
+    } else if (auto media_card = page_cast<MediaCard>(page)) {
+      add_page(media_card->get_media_entity(), i);
     }
-    else if (entity_type == entity_type::alarm_control_panel &&
-        this->current_page_->is_type(page_type::cardAlarm)) {
-      force_current_page_update_ = true;
-      return;
+  }
+}
+
+uint16_t NSPanelLovelace::find_entity_index_(const Entity *entity) const {
+  uint16_t index = 0;
+  for (auto &e : this->entities_) {
+    if (e.get() == entity) break;
+    index++;
+  }
+  return index;
+}
+
+bool NSPanelLovelace::is_popup_item_of_(uint16_t entity_index, const StatefulPageItem *item) const {
+  if (item == nullptr) return false;
+  auto &items = this->entity_references_[entity_index].popup_items;
+  return std::find(items.begin(), items.end(), item) != items.end();
+}
+
+// Caches which entities are displayed on the current page, so the checks
+// when entities change are a single lookup
+void NSPanelLovelace::update_entity_visibility_() {
+  for (size_t i = 0; i < this->entity_references_.size(); i++) {
+    auto &pages = this->entity_references_[i].pages;
+    this->entity_visible_[i] = this->current_page_ != nullptr &&
+      std::find(pages.begin(), pages.end(), this->current_page_index_) != pages.end();
+  }
+}
+
+void NSPanelLovelace::defer_entity_changes_(uint16_t entity_index) {
+  this->deferred_update_count_++;
+  if (std::find(this->deferred_entities_.begin(), this->deferred_entities_.end(),
+      entity_index) == this->deferred_entities_.end()) {
+    this->deferred_entities_.push_back(entity_index);
+  }
+}
+
+// Notifies the subscribers of deferred entities which are now visible,
+// this must be called before the current page is rendered
+void NSPanelLovelace::flush_deferred_changes_() {
+  auto it = this->deferred_entities_.begin();
+  while (it != this->deferred_entities_.end()) {
+    if (!this->entity_visible_[*it]) {
+      ++it;
+      continue;
     }
-    
-    // todo: implement popup page checks too
-    // if (this->popup_page_current_uuid_ == item->get_uuid()) {
-    //   this->render_popup_page_update_(item);
-    // } else if (this->popup_page_current_uuid_.empty()) {
-    //   this->render_item_update_(this->current_page_);
-    // }
-  });
+    this->entities_[*it]->flush_changes();
+    this->deferred_flush_count_++;
+    it = this->deferred_entities_.erase(it);
+  }
 }
 
 void NSPanelLovelace::send_weather_update_command_() {
   if (this->current_page_ != this->screensaver_)
     return;
+  render_stat_scope stat(this->get_render_stat_(
+    static_cast<uint8_t>(page_type::screensaver)), this->command_buffer_);
   this->screensaver_->render(this->command_buffer_);
+  stat.finish();
   this->send_buffered_command_();
 }
 
-void NSPanelLovelace::on_weather_state_update_(std::string entity_id, std::string state) {
+void NSPanelLovelace::on_weather_state_update_(std::string state) {
   if (this->screensaver_ == nullptr) return;
   auto item = this->screensaver_->get_item<WeatherItem>(0);
   if (item == nullptr) return;
@@ -2291,7 +2639,7 @@ void NSPanelLovelace::on_weather_state_update_(std::string entity_id, std::strin
   this->send_weather_update_command_();
 }
 
-void NSPanelLovelace::on_weather_temperature_update_(std::string entity_id, std::string temperature) {
+void NSPanelLovelace::on_weather_temperature_update_(std::string temperature) {
   if (this->screensaver_ == nullptr) return;
   auto item = this->screensaver_->get_item<WeatherItem>(0);
   if (item == nullptr) return;
@@ -2299,14 +2647,14 @@ void NSPanelLovelace::on_weather_temperature_update_(std::string entity_id, std:
   this->send_weather_update_command_();
 }
 
-void NSPanelLovelace::on_weather_temperature_unit_update_(std::string entity_id, std::string temperature_unit) {
+void NSPanelLovelace::on_weather_temperature_unit_update_(std::string temperature_unit) {
   if (this->screensaver_ == nullptr) return;
   WeatherItem::temperature_unit = std::move(temperature_unit);
   this->screensaver_->set_items_render_invalid();
   this->send_weather_update_command_();
 }
 
-void NSPanelLovelace::on_weather_forecast_update_(std::string entity_id, std::string forecast_json) {
+void NSPanelLovelace::on_weather_forecast_update_(std::string forecast_json) {
   if (this->screensaver_ == nullptr) return;
   // todo: check if we are on the screensaver otherwise don't update
   // todo: implement color updates: "color~background~tTime~timeAMPM~tDate~tMainText~tForecast1~tForecast2~tForecast3~tForecast4~tForecast1Val~tForecast2Val~tForecast3Val~tForecast4Val~bar~tMainTextAlt2~tTimeAdd"
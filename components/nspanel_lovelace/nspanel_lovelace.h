@@ -2,9 +2,10 @@
 
 #include "defines.h"
 
+#include <array>
 #include <functional>
+#include <initializer_list>
 #include <memory>
-#include <map>
 #include <queue>
 #include <stdint.h>
 #include <utility>
@@ -13,6 +14,7 @@
 #include "esphome/core/defines.h"
 #include "esphome/core/automation.h"
 #include "esphome/core/component.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/preferences.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/components/api/custom_api_device.h"
@@ -51,6 +53,107 @@ PACK(struct NSPanelRestoreState {
   uint8_t display_inactive_dim_ = 50;
 });
 
+// Identifies a Home Assistant subscription, this is small enough to be
+// captured by value in the subscription callback
+struct entity_subscription_record {
+  uint16_t entity_index;
+  ha_attr_type attr;
+};
+
+// Page indexes are stored as uint8_t, the config allows no more pages
+static constexpr size_t MAX_PAGES = UINT8_MAX;
+
+// Everything which displays an entity
+struct entity_references {
+  // indexes of pages_ which show the entity
+  std::vector<uint8_t> pages;
+  // items which can open a detail popup for the entity
+  std::vector<StatefulPageItem*> popup_items;
+};
+
+// The data of a service call, the value must outlive the call
+struct ha_service_data {
+  ha_attr_type key;
+  const std::string &value;
+};
+
+// A value which is displayed before Home Assistant has confirmed it
+struct optimistic_update {
+  uint16_t entity_index;
+  ha_attr_type attr;
+  uint32_t started;
+  // the value before the first optimistic update, restored on timeout
+  std::string previous;
+  std::string expected;
+};
+
+struct control_coalescer {
+  // uuid or entity id the button press was sent for
+  std::string internal_id;
+  control_type type;
+  // a value is waiting for the interval to pass
+  bool pending;
+  uint32_t last_sent;
+  std::string value;
+};
+
+// render_stat slots after the one for every page_type
+static constexpr uint8_t RENDER_STAT_STATUS_UPDATE = PAGE_TYPE_COUNT;
+static constexpr uint8_t RENDER_STAT_POPUP_DETAIL = PAGE_TYPE_COUNT + 1;
+static constexpr uint8_t RENDER_STAT_COUNT = PAGE_TYPE_COUNT + 2;
+
+// Time and output of all renders of one kind
+struct render_stat {
+  uint32_t count;
+  uint32_t time_us;
+  uint32_t max_time_us;
+  uint32_t bytes;
+  // renders which had to grow the buffer, each one is a heap allocation
+  uint32_t buffer_grows;
+};
+
+// Adds the render into buffer made while in scope, or until finish(),
+// to stat. Does nothing when stat is nullptr
+class render_stat_scope {
+public:
+  render_stat_scope(render_stat *stat, const std::string &buffer) :
+      stat_(stat), buffer_(buffer),
+      started_(stat == nullptr ? 0 : micros()),
+      capacity_(buffer.capacity()) {}
+  ~render_stat_scope() { this->finish(); }
+  // Adds the render to stat now, call it before the buffer is sent
+  void finish() {
+    if (this->stat_ == nullptr) return;
+    const uint32_t elapsed = micros() - this->started_;
+    this->stat_->count++;
+    this->stat_->time_us += elapsed;
+    if (elapsed > this->stat_->max_time_us)
+      this->stat_->max_time_us = elapsed;
+    this->stat_->bytes += this->buffer_.length();
+    if (this->buffer_.capacity() != this->capacity_)
+      this->stat_->buffer_grows++;
+    this->stat_ = nullptr;
+  }
+  // nothing was rendered, don't count it
+  void discard() { this->stat_ = nullptr; }
+
+protected:
+  render_stat *stat_;
+  const std::string &buffer_;
+  uint32_t started_;
+  size_t capacity_;
+};
+
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+PACK(struct NSPanelStateSnapshot {
+  // hash of all entity ids, the snapshot is discarded when they change
+  uint32_t entities_hash = 0;
+  uint16_t length = 0;
+  // records of {entity index}{ha_attr_type}{value length}{value}
+  uint8_t data[STATE_SNAPSHOT_SIZE];
+});
+#endif
+
 class NSPanelLovelace : public Component, public uart::UARTDevice, protected api::CustomAPIDevice {
 public:
   NSPanelLovelace();
@@ -58,6 +161,8 @@ public:
   void loop() override;
 
   std::shared_ptr<Entity> create_entity(const std::string &entity_id);
+  std::shared_ptr<Entity> create_entity(const std::string &entity_id,
+      entity_usage usage, ha_attr_mask extra_attrs = 0);
 
   template <class TPage, class... TArgs>
   TPage* create_page(TArgs&&... args) {
@@ -103,11 +208,23 @@ public:
   void on_page_item_added_callback(const std::shared_ptr<PageItem> &item);
   void set_language(const std::string &language) { this->language_ = language; }
   void set_display_timeout(uint16_t timeout);
+  // Only store updates for entities which aren't displayed, the subscribers
+  // are notified when a page that shows the entity is rendered
+  void set_defer_hidden_updates(bool defer) { this->defer_hidden_updates_ = defer; }
+  // Minimum time between service calls while a slider is being dragged,
+  // the last value is always sent once the interval has passed
+  void set_control_interval(control_type type, uint16_t interval_ms);
+  // Show the expected result of an action straight away instead of waiting
+  // for Home Assistant to send the new state
+  void set_optimistic_updates(bool enabled) { this->optimistic_updates_ = enabled; }
   void set_display_active_dim(uint8_t active);
   void set_display_inactive_dim(uint8_t inactive);
   // Note: this can be used without parameters to update the display without changing the levels
   void set_display_dim(uint8_t inactive = UINT8_MAX, uint8_t active = UINT8_MAX);
   void set_weather_entity_id(const std::string &weather_entity_id) { this->weather_entity_id_ = weather_entity_id; }
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+  void set_state_snapshot_interval(uint32_t interval_ms) { this->state_snapshot_interval_ = interval_ms; }
+#endif
 
   void render_screensaver() { this->render_page_(render_page_option::screensaver); }
   void render_next_page() { this->render_page_(render_page_option::next); }
@@ -158,6 +275,16 @@ protected:
   bool save_state_();
   ESPPreferenceObject pref_;
 
+#ifdef USE_NSPANEL_STATE_SNAPSHOT
+  uint32_t get_entities_hash_() const;
+  bool restore_state_snapshot_();
+  bool save_state_snapshot_();
+  ESPPreferenceObject snapshot_pref_;
+  uint32_t state_snapshot_interval_ = 600000;
+  uint16_t state_snapshot_crc_ = 0;
+  bool state_snapshot_dirty_ = false;
+#endif
+
   void init_display_(int baud_rate);
 #ifdef USE_NSPANEL_TFT_UPLOAD
   uint16_t recv_ret_string_(std::string &response, uint32_t timeout, bool recv_flag);
@@ -167,13 +294,8 @@ protected:
 #endif
   void send_nextion_command_(const std::string &command);
 
-  void subscribe_homeassistant_state_attr(
-      void (NSPanelLovelace::*callback)(std::string, std::string, std::string),
-      std::string entity_id, std::string attribute) {
-    auto f = std::bind(callback, this, entity_id, attribute, std::placeholders::_1);
-    api::global_api_server->
-      subscribe_home_assistant_state(entity_id, optional<std::string>(attribute), f);
-  }
+  // All entity subscriptions are routed through on_entity_subscription_update_
+  void subscribe_entity_(uint16_t entity_index, ha_attr_type attr);
 
   bool process_data_();
   size_t find_page_index_by_uuid_(const std::string &uuid) const;
@@ -184,13 +306,28 @@ protected:
   void process_button_press_(std::string &entity_id,
     const std::string &button_type,
     const std::string &value = "", bool called_from_timeout = false);
+  bool coalesce_control_press_(const std::string &internal_id,
+    const std::string &button_type, const std::string &value);
+  void process_pending_controls_();
+  void apply_optimistic_update_(const std::string &entity_id,
+    ha_attr_type attr, const std::string &value);
+  void reconcile_optimistic_update_(uint16_t entity_index, ha_attr_type attr);
+  void expire_optimistic_updates_();
   StatefulPageItem* get_page_item_(const std::string &uuid);
   Entity* get_entity_(const std::string &entity_id);
 
   void render_page_(size_t index);
   void render_page_(render_page_option d);
+  size_t get_page_index_(render_page_option d) const;
+  // The pages which can be reached from the current page with one swipe,
+  // and the default page when the screensaver is shown
+  std::array<size_t, 3> get_neighbour_page_indexes_() const;
+  // Updates the cached output of one neighbour page, called when idle
+  void prerender_neighbour_pages_();
   void render_current_page_();
   void render_item_update_(Page *page);
+  // Frees the cached output of pages which can't be reached with one swipe
+  void release_render_caches_();
   void render_popup_notify_page_(const std::string &internal_id,
     const std::string &heading, const std::string &message, uint16_t timeout = 0U,
     const std::string &btn1_text = "", const std::string &btn2_text = "");
@@ -219,43 +356,90 @@ protected:
   uint8_t display_inactive_dim_ = 50;
   
   void call_ha_service_(
-    const std::string& service, const std::string& entity_id);
+    const char *service, const std::string &entity_id);
   void call_ha_service_(
-    const char *entity_type, const std::string &action, const std::string& entity_id);
+    entity_kind kind, const char *action, const std::string &entity_id);
   void call_ha_service_(
-    const char *entity_type, const std::string &action,
-    const std::map<std::string, std::string> &data,
-    const std::map<std::string, std::string> &data_template = {});
+    entity_kind kind, const char *action,
+    std::initializer_list<ha_service_data> data,
+    std::initializer_list<ha_service_data> data_template = {});
   void call_ha_service_(
-    const std::string& service,
-    const std::map<std::string, std::string> &data,
-    const std::map<std::string, std::string> &data_template = {});
-  void on_entity_state_update_(std::string entity_id, std::string state);
+    const char *service,
+    std::initializer_list<ha_service_data> data,
+    std::initializer_list<ha_service_data> data_template = {});
+  void send_ha_service_call_(
+    std::initializer_list<ha_service_data> data,
+    std::initializer_list<ha_service_data> data_template);
+  // reused by every service call to avoid allocating
+  api::HomeassistantServiceResponse service_call_;
+  void on_entity_subscription_update_(
+    entity_subscription_record record, std::string value);
   void on_entity_attribute_update_(
-    std::string entity_id, std::string attr_name, std::string attr_value);
-
-  void on_weather_state_update_(std::string entity_id, std::string state);
-  void on_weather_temperature_update_(std::string entity_id, std::string temperature);
-  void on_weather_temperature_unit_update_(std::string entity_id, std::string temperature_unit);
-  void on_weather_forecast_update_(std::string entity_id, std::string forecast_json);
+    uint16_t entity_index, ha_attr_type attr, std::string attr_value);
+  void mark_entity_dirty_(uint16_t entity_index);
+  void flush_dirty_entities_();
+  void build_entity_references_();
+  uint16_t find_entity_index_(const Entity *entity) const;
+  bool is_popup_item_of_(uint16_t entity_index, const StatefulPageItem *item) const;
+  void update_entity_visibility_();
+  void defer_entity_changes_(uint16_t entity_index);
+  void flush_deferred_changes_();
+
+  void on_weather_state_update_(std::string state);
+  void on_weather_temperature_update_(std::string temperature);
+  void on_weather_temperature_unit_update_(std::string temperature_unit);
+  void on_weather_forecast_update_(std::string forecast_json);
   void send_weather_update_command_();
   std::string weather_entity_id_;
   std::string language_;
 
   std::queue<std::string> command_queue_;
+  // buffers of sent commands which are reused for queuing new ones
+  std::vector<std::string> command_pool_;
   unsigned long command_last_sent_ = 0;
 
-  bool button_press_timeout_set_ = false;
-  std::string button_press_uuid_;
-  std::string button_press_type_;
-  std::string button_press_value_;
+  // sliders which have sent a service call within their interval
+  std::vector<control_coalescer> controls_;
+  std::array<uint16_t, CONTROL_TYPE_COUNT> control_intervals_;
+  uint32_t control_coalesced_count_ = 0;
+  bool optimistic_updates_ = true;
+  std::vector<optimistic_update> optimistic_pending_;
+  uint32_t optimistic_confirmed_count_ = 0;
+  uint32_t optimistic_corrected_count_ = 0;
+  uint32_t optimistic_reverted_count_ = 0;
+  // time until Home Assistant confirmed an optimistic update
+  uint32_t optimistic_latency_total_ = 0;
+  uint32_t optimistic_latency_max_ = 0;
 
   uint8_t current_page_index_ = 0;
+  uint32_t prerender_count_ = 0;
+  // anything left in command_buffer_ is sent, so prerendering
+  // builds pages in a buffer of its own
+  std::string prerender_scratch_;
+#ifdef USE_NSPANEL_RENDER_STATS
+  std::array<render_stat, RENDER_STAT_COUNT> render_stats_{};
+#endif
+  // The render_stat for slot or nullptr if render stats are disabled
+  render_stat *get_render_stat_(uint8_t slot);
   std::string popup_page_current_uuid_;
   Page* current_page_ = nullptr;
   bool force_current_page_update_ = false;
   Screensaver* screensaver_ = nullptr;
   std::vector<std::shared_ptr<Entity>> entities_;
+  uint16_t subscription_count_ = 0;
+  size_t subscription_heap_used_ = 0;
+  // indexed the same as entities_
+  std::vector<entity_references> entity_references_;
+  std::vector<bool> entity_visible_;
+  // entities with changes which haven't been flushed yet
+  std::vector<bool> entity_dirty_;
+  std::vector<uint16_t> dirty_entities_;
+  uint32_t flush_started_ = 0;
+  uint32_t flush_delay_ = 0;
+  bool defer_hidden_updates_ = false;
+  std::vector<uint16_t> deferred_entities_;
+  uint32_t deferred_update_count_ = 0;
+  uint32_t deferred_flush_count_ = 0;
   std::vector<std::shared_ptr<Page>> pages_;
   std::vector<std::shared_ptr<StatefulPageItem>> stateful_page_items_;
   StatefulPageItem* cached_page_item_ = nullptr;
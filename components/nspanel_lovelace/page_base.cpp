@@ -31,7 +31,7 @@ Page::Page(
     uuid_(uuid), type_(type), render_type_(type),
     title_(title), hidden_(false), sleep_timeout_(sleep_timeout) {}
 
-// Copy constructor overridden so the uuid is cleared
+// Copy constructor overridden so the uuid and render cache are cleared
 Page::Page(const Page &other) :
     uuid_(""), type_(other.type_), render_type_(other.render_type_),
     title_(other.title_), hidden_(other.hidden_),
@@ -70,6 +70,8 @@ void Page::add_item(const std::shared_ptr<PageItem> &item) {
     }
   }
   this->items_.push_back(item);
+  item->set_page(this);
+  this->render_invalid_ = true;
   this->on_item_added_(item);
 }
 
@@ -83,5 +85,81 @@ void Page::on_item_added_(const std::shared_ptr<PageItem> &item) {
   this->on_item_added_callback_(item);
 }
 
+std::string &Page::render_items_(std::string &buffer) {
+  this->item_spans_.resize(this->items_.size());
+  for (size_t i = 0; i < this->items_.size(); i++) {
+    auto &output = this->items_[i]->render();
+    buffer.append(1, SEPARATOR);
+    this->item_spans_[i] = {
+      static_cast<uint16_t>(buffer.length()),
+      static_cast<uint16_t>(output.length())};
+    buffer.append(output);
+  }
+  this->items_render_invalid_ = false;
+  return buffer;
+}
+
+std::string &Page::render(std::string &buffer) {
+  if (this->render_invalid_) {
+    // the caller's buffer is the scratch space, once the length
+    // is known the cache is allocated to exactly that size
+    this->item_spans_.clear();
+    this->render_(buffer);
+    assign_exact(this->render_buffer_, buffer);
+    this->render_length_ = buffer.length();
+    this->render_invalid_ = false;
+    this->items_render_invalid_ = false;
+    return buffer;
+  }
+  if (this->items_render_invalid_) {
+    this->update_item_spans_(buffer);
+    this->render_length_ = this->render_buffer_.length();
+    this->items_render_invalid_ = false;
+  }
+  return buffer.assign(this->render_buffer_.data(), this->render_buffer_.length());
+}
+
+bool Page::prerender(std::string &scratch) {
+  if (this->render_invalid_) {
+    this->render(scratch);
+    return true;
+  }
+  if (this->items_render_invalid_) {
+    this->update_item_spans_(scratch);
+    this->render_length_ = this->render_buffer_.length();
+    this->items_render_invalid_ = false;
+    return true;
+  }
+  return false;
+}
+
+void Page::release_render_cache() {
+  psram_string().swap(this->render_buffer_);
+  std::vector<item_span>().swap(this->item_spans_);
+  this->render_invalid_ = true;
+}
+
+void Page::update_item_spans_(std::string &buffer) {
+  // items aren't tracked when the page renders them itself
+  if (this->item_spans_.size() != this->items_.size()) {
+    this->item_spans_.clear();
+    this->render_(buffer);
+    assign_exact(this->render_buffer_, buffer);
+    return;
+  }
+  int32_t shift = 0;
+  for (size_t i = 0; i < this->items_.size(); i++) {
+    auto &span = this->item_spans_[i];
+    span.offset += shift;
+    auto &item = this->items_[i];
+    if (!item->get_render_invalid()) continue;
+    auto &output = item->render();
+    this->render_buffer_.replace(
+        span.offset, span.length, output.data(), output.length());
+    shift += static_cast<int32_t>(output.length()) - span.length;
+    span.length = output.length();
+  }
+}
+
 } // namespace nspanel_lovelace
 } // namespace esphome
\ No newline at end of file
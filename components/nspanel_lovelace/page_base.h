@@ -32,21 +32,45 @@ public:
   const std::string &get_uuid() const { return this->uuid_; }
   const std::string &get_title() const { return this->title_; }
   bool is_type(page_type type) const;
+  page_type get_type() const { return this->type_; }
   const char *get_render_type_str() const;
   void set_render_type(page_type type);
   bool is_hidden() const { return this->hidden_; }
   uint16_t get_sleep_timeout() const { return this->sleep_timeout_; }
 
   virtual void set_uuid(const std::string &uuid) { this->uuid_ = uuid; }
-  virtual void set_title(const std::string &title) { this->title_ = title; }
+  virtual void set_title(const std::string &title) {
+    this->title_ = title;
+    this->render_invalid_ = true;
+  }
   virtual void set_hidden(const bool hidden) { this->hidden_ = hidden; }
   virtual void set_sleep_timeout(const uint16_t timeout) {
     this->sleep_timeout_ = timeout;
   }
   
   virtual void set_items_render_invalid();
+  // Forces the next render() to rebuild the whole output
+  void set_render_invalid() { this->render_invalid_ = true; }
+  // Called by items of this page when their output changes
+  virtual void on_item_render_invalid(const PageItem *item) {
+    this->items_render_invalid_ = true;
+  }
 
-  virtual std::string &render(std::string &buffer) = 0;
+  // Copies the page output to buffer, the output is cached and only
+  // rebuilt when the page or one of its items has changed
+  std::string &render(std::string &buffer);
+  // Brings the cached output up to date without copying it out so a later
+  // render() is only a copy, returns false when it already was
+  bool prerender(std::string &scratch);
+  // Frees the cached output, the next render() rebuilds it
+  void release_render_cache();
+  bool has_render_cache() const { return !this->render_buffer_.empty(); }
+  size_t get_render_cache_size() const {
+    return this->render_buffer_.capacity() +
+        this->item_spans_.capacity() * sizeof(item_span);
+  }
+  // Length of the last output, kept after the cache is released
+  uint16_t get_render_length() const { return this->render_length_; }
 
   void add_item(const std::shared_ptr<PageItem> &item);
   void add_item_range(const std::vector<std::shared_ptr<PageItem>> &items);
@@ -73,6 +97,14 @@ protected:
   virtual const char *get_render_instruction() const = 0;
   virtual void on_item_added_(const std::shared_ptr<PageItem> &item);
 
+  // Builds the whole page output
+  virtual std::string &render_(std::string &buffer) = 0;
+  // Appends every item with a leading separator and remembers
+  // where each one is so it can be replaced on its own later
+  std::string &render_items_(std::string &buffer);
+  // Replaces the output of the items which changed since the last render
+  void update_item_spans_(std::string &buffer);
+
   std::string uuid_;
   page_type type_;
   page_type render_type_;
@@ -82,6 +114,19 @@ protected:
 
   std::vector<std::shared_ptr<PageItem>> items_;
   std::function<void(const std::shared_ptr<PageItem>&)> on_item_added_callback_;
+
+  struct item_span {
+    uint16_t offset;
+    uint16_t length;
+  };
+  // The last output of render(), which is rebuilt when render_invalid_ is set.
+  // Only read when the page is shown so it is kept in PSRAM if there is some.
+  psram_string render_buffer_;
+  uint16_t render_length_ = 0;
+  bool render_invalid_ = true;
+  bool items_render_invalid_ = false;
+  // position of each item in render_buffer_, indexed like items_
+  std::vector<item_span> item_spans_;
 };
 
 } // namespace nspanel_lovelace
@@ -2,6 +2,7 @@
 
 #include "config.h"
 #include "helpers.h"
+#include "page_base.h"
 #include "types.h"
 #include <algorithm>
 
@@ -21,11 +22,31 @@ PageItem::PageItem(const PageItem &other) :
 
 void PageItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
+void PageItem::set_render_invalid() {
+  this->render_invalid_ = true;
+  if (this->page_ != nullptr) {
+    this->page_->on_item_render_invalid(this);
+  }
+}
+
 const std::string &PageItem::render() {
+  // Rendered into a shared buffer first so the length is known and the
+  // item's buffer is only allocated once. Note: items never render other
+  // items, otherwise this buffer would be overwritten.
+  static std::string scratch;
+  if (this->page_ != nullptr) {
+    // the page keeps the output in its own cache so the item doesn't need
+    // a copy, the result is only valid until the next item is rendered
+    scratch.clear();
+    this->render_(scratch);
+    this->render_invalid_ = false;
+    return scratch;
+  }
   // only re-render if values have changed
   if (this->render_invalid_) {
-    this->render_buffer_.clear();
-    this->render_(this->render_buffer_);
+    scratch.clear();
+    this->render_(scratch);
+    assign_exact(this->render_buffer_, scratch);
     this->render_invalid_ = false;
   }
   return this->render_buffer_;
@@ -43,28 +64,36 @@ PageItem_Icon::PageItem_Icon(IHaveRenderInvalid *const parent) :
     ISetRenderInvalid(parent), 
     icon_default_value_(icon_t::help_circle_outline), icon_default_color_(17299u),
     icon_value_(icon_default_value_), icon_color_(icon_default_color_),
-    icon_value_overridden_(false), icon_color_overridden_(false) {}
+    icon_value_overridden_(false), icon_color_overridden_(false) {
+  this->update_icon_color_(this->icon_color_);
+}
 
 PageItem_Icon::PageItem_Icon(
     IHaveRenderInvalid *const parent, const icon_char_t *icon_default_value) :
     ISetRenderInvalid(parent),
     icon_default_value_(icon_default_value), icon_default_color_(17299u),
     icon_value_(icon_default_value), icon_color_(icon_default_color_),
-    icon_value_overridden_(false), icon_color_overridden_(false) {}
+    icon_value_overridden_(false), icon_color_overridden_(false) {
+  this->update_icon_color_(this->icon_color_);
+}
 
 PageItem_Icon::PageItem_Icon(
     IHaveRenderInvalid *const parent, const uint16_t icon_default_color) :
     ISetRenderInvalid(parent),
     icon_default_value_(icon_t::help_circle_outline), icon_default_color_(icon_default_color),
     icon_value_(icon_default_value_), icon_color_(icon_default_color),
-    icon_value_overridden_(false), icon_color_overridden_(false) {}
+    icon_value_overridden_(false), icon_color_overridden_(false) {
+  this->update_icon_color_(this->icon_color_);
+}
 
 PageItem_Icon::PageItem_Icon(
     IHaveRenderInvalid *const parent, const icon_char_t *icon_default_value, const uint16_t icon_default_color) :
     ISetRenderInvalid(parent), 
     icon_default_value_(icon_default_value), icon_default_color_(icon_default_color),
     icon_value_(icon_default_value), icon_color_(icon_default_color),
-    icon_value_overridden_(false), icon_color_overridden_(false) {}
+    icon_value_overridden_(false), icon_color_overridden_(false) {
+  this->update_icon_color_(this->icon_color_);
+}
 
 void PageItem_Icon::set_icon_value(const icon_char_t *value) {
   this->icon_value_ = value;
@@ -79,19 +108,19 @@ void PageItem_Icon::reset_icon_value() {
 }
 
 void PageItem_Icon::set_icon_color(const uint16_t color) {
-  this->icon_color_ = color;
+  this->update_icon_color_(color);
   this->icon_color_overridden_ = true;
   set_render_invalid_();
 }
 
 void PageItem_Icon::set_icon_color(const std::array<uint8_t, 3> rgb) {
-  this->icon_color_ = rgb_dec565(rgb[0], rgb[1], rgb[2]);
+  this->update_icon_color_(rgb_dec565(rgb[0], rgb[1], rgb[2]));
   this->icon_color_overridden_ = true;
   set_render_invalid_();
 }
 
 void PageItem_Icon::reset_icon_color() {
-  this->icon_color_ = this->icon_default_color_;
+  this->update_icon_color_(this->icon_default_color_);
   this->icon_color_overridden_ = false;
   set_render_invalid_();
 }
@@ -106,6 +135,13 @@ std::string &PageItem_Icon::render_(std::string &buffer) {
     .append(this->get_icon_color_str());
 }
 
+void PageItem_Icon::update_icon_color_(const uint16_t color) {
+  this->icon_color_ = color;
+  num_str str(color);
+  std::memcpy(this->icon_color_str_, str.data(), str.length());
+  this->icon_color_str_length_ = str.length();
+}
+
 /*
  * =============== PageItem_DisplayName ===============
  */
@@ -197,15 +233,12 @@ StatefulPageItem::~StatefulPageItem() {
 
 void StatefulPageItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
-void StatefulPageItem::on_entity_type_change(const char *type) {
-  if (type == entity_type::delete_) {
-    this->render_type_ = "";
-  }
-
+void StatefulPageItem::on_entity_type_change(entity_kind kind) {
+  const char *type = to_string(kind);
   this->render_type_ = get_value_or_default(ENTITY_RENDER_TYPE_MAP,
     type, entity_render_type::text);
 
-  if (type != entity_type::sensor) {
+  if (kind != entity_kind::sensor) {
     const icon_char_t *icon;
     if (try_get_value(ENTITY_ICON_MAP, icon, type)) {
       this->icon_value_ = this->icon_default_value_ = icon;
@@ -213,79 +246,101 @@ void StatefulPageItem::on_entity_type_change(const char *type) {
   }
   this->icon_value_overridden_ = false;
 
-  this->set_on_state_callback_(type);
+  this->set_on_state_callback_(kind);
 
   this->set_render_invalid();
 
   // also need to make sure the state is updated based on the new 'type'
-  if (this->on_state_callback_) {
-    this->on_state_callback_(this);
-  }
+  this->state_stale_ = true;
 }
 
-void StatefulPageItem::on_entity_state_change(const std::string &state) {
-  this->set_render_invalid();
-
-  if (this->on_state_callback_) {
-    this->on_state_callback_(this);
+void StatefulPageItem::on_entity_changed(ha_attr_mask changed) {
+  // this class only needs to react to the state and the following attributes
+  if (!this->icon_value_overridden_) {
+    if ((changed & to_mask(ha_attr_type::device_class)) &&
+        this->entity_->is_type(entity_kind::sensor)) {
+      this->icon_default_value_ = this->icon_value_ = get_icon(SENSOR_ICON_MAP,
+        this->entity_->get_attribute(ha_attr_type::device_class));
+    }
+    if (changed & to_mask(ha_attr_type::media_content_type)) {
+      this->icon_value_ = get_icon(MEDIA_TYPE_ICON_MAP,
+        this->entity_->get_attribute(ha_attr_type::media_content_type),
+        entity_state::off);
+    }
   }
-}
 
-void StatefulPageItem::on_entity_attribute_change(ha_attr_type attr, const std::string &value) {
-  // this class only needs to react to the following attributes
-  if (attr == ha_attr_type::device_class) {
-    if (!this->icon_value_overridden_) {
-      if (this->entity_->is_type(entity_type::sensor)) {
-        this->icon_default_value_ = this->icon_value_ =
-          get_icon(SENSOR_ICON_MAP, value);
-      }
-    }
-  } else if (attr == ha_attr_type::media_content_type) {
-    if (this->icon_value_overridden_) return;
-    this->icon_value_ = get_icon(MEDIA_TYPE_ICON_MAP,
-      this->entity_->get_attribute(ha_attr_type::media_content_type),
-      entity_state::off);
-  } else {
+  if ((changed & (
+      to_mask(ha_attr_type::state) |
+      to_mask(ha_attr_type::device_class) |
+      to_mask(ha_attr_type::media_content_type))) == 0) {
     return;
   }
 
+  this->set_render_invalid();
+  this->state_stale_ = true;
+}
+
+const std::string &StatefulPageItem::render() {
+  this->update_state();
+  return PageItem::render();
+}
+
+void StatefulPageItem::update_state() {
+  if (!this->state_stale_) return;
+  this->state_stale_ = false;
   if (this->on_state_callback_) {
     this->on_state_callback_(this);
   }
+}
 
-  this->set_render_invalid();
+constexpr StatefulPageItem::state_callback_t
+    StatefulPageItem::select_state_callback_(entity_kind kind) {
+  switch(kind) {
+    case entity_kind::light:
+    case entity_kind::switch_:
+    case entity_kind::input_boolean:
+    case entity_kind::automation:
+    case entity_kind::fan:
+      return StatefulPageItem::state_on_off_fn;
+    case entity_kind::binary_sensor:
+      return StatefulPageItem::state_binary_sensor_fn;
+    case entity_kind::cover:
+      return StatefulPageItem::state_cover_fn;
+    case entity_kind::climate:
+      return StatefulPageItem::state_climate_fn;
+    case entity_kind::media_player:
+      return StatefulPageItem::state_media_fn;
+    case entity_kind::sun:
+      return StatefulPageItem::state_sun_fn;
+    case entity_kind::alarm_control_panel:
+      return StatefulPageItem::state_alarm_fn;
+    case entity_kind::lock:
+      return StatefulPageItem::state_lock_fn;
+    case entity_kind::weather:
+      return StatefulPageItem::state_weather_fn;
+    default:
+      return nullptr;
+  }
 }
 
-void StatefulPageItem::set_on_state_callback_(const char *type) {
-  if (type == entity_type::light ||
-      type == entity_type::switch_ ||
-      type == entity_type::input_boolean ||
-      type == entity_type::automation ||
-      type == entity_type::fan) {
-    this->on_state_callback_ = StatefulPageItem::state_on_off_fn;
-  } else if (type == entity_type::binary_sensor) {
-    this->on_state_callback_ = StatefulPageItem::state_binary_sensor_fn;
-  } else if (type == entity_type::cover) {
-    this->on_state_callback_ = StatefulPageItem::state_cover_fn;
-  } else if (type == entity_type::climate) {
-    this->on_state_callback_ = StatefulPageItem::state_climate_fn;
-  } else if (type == entity_type::media_player) {
-    this->on_state_callback_ = StatefulPageItem::state_media_fn;
-  } else if (type == entity_type::sun) {
-    this->on_state_callback_ = StatefulPageItem::state_sun_fn;
-  } else if (type == entity_type::alarm_control_panel) {
-    this->on_state_callback_ = StatefulPageItem::state_alarm_fn;
-  } else if (type == entity_type::lock) {
-    this->on_state_callback_ = StatefulPageItem::state_lock_fn;
-  } else if (type == entity_type::weather) {
-    this->on_state_callback_ = StatefulPageItem::state_weather_fn;
+// built at compile time, kinds without a callback map to nullptr
+const std::array<StatefulPageItem::state_callback_t, ENTITY_KIND_COUNT>
+    StatefulPageItem::state_callbacks_ = make_entity_kind_table(
+      StatefulPageItem::select_state_callback_);
+
+void StatefulPageItem::set_on_state_callback_(entity_kind kind) {
+  if (static_cast<size_t>(kind) >= ENTITY_KIND_COUNT) {
+    this->on_state_callback_ = nullptr;
+    return;
   }
+  this->on_state_callback_ =
+    StatefulPageItem::state_callbacks_[static_cast<size_t>(kind)];
 }
 
 std::string &StatefulPageItem::render_(std::string &buffer) {
   // type~
   buffer.append(this->render_type_).append(1, SEPARATOR);
-  if (this->entity_->is_type(entity_type::delete_))
+  if (this->entity_->is_type(entity_kind::delete_))
     // internalName(delete)~
     buffer.append(entity_type::delete_).append(1, SEPARATOR);
   else
@@ -294,15 +349,6 @@ std::string &StatefulPageItem::render_(std::string &buffer) {
   // iconValue~iconColor~
   return PageItem_Icon::render_(buffer).append(1, SEPARATOR);
 }
-  
-uint16_t StatefulPageItem::get_render_buffer_reserve_() const {
-  // try to guess the required size of the buffer to reduce heap fragmentation
-  return strlen(this->render_type_) + 
-      this->uuid_.length() + 6 +
-      this->get_icon_color_str().length() + 
-      // icon is 4 char long + separator chars
-      9;
-}
 
 void StatefulPageItem::state_on_off_fn(StatefulPageItem *me) {
   if (me->icon_color_overridden_) {
@@ -310,18 +356,18 @@ void StatefulPageItem::state_on_off_fn(StatefulPageItem *me) {
   }
 
   if (me->is_state(entity_state::on)) {
-    me->icon_color_ = 64909u; // yellow
+    me->update_icon_color_(64909u); // yellow
   } else if (me->is_state(entity_state::off)) {
-    me->icon_color_ = 17299u; // blue
+    me->update_icon_color_(17299u); // blue
   } else {
-    me->icon_color_ = 38066u; // grey
+    me->update_icon_color_(38066u); // grey
   }
 }
 
 void StatefulPageItem::state_binary_sensor_fn(StatefulPageItem *me) {
   if (me->is_state(entity_state::on)) {
     if (!me->icon_color_overridden_)
-      me->icon_color_ = 64909u; // yellow
+      me->update_icon_color_(64909u); // yellow
     if (!me->icon_value_overridden_) {
       me->icon_value_ = get_value_or_default(SENSOR_ON_ICON_MAP,
         me->get_attribute(ha_attr_type::device_class),
@@ -330,9 +376,9 @@ void StatefulPageItem::state_binary_sensor_fn(StatefulPageItem *me) {
   } else {
     if (!me->icon_color_overridden_) {
       if (me->is_state(entity_state::off))
-        me->icon_color_ = 17299u; // blue
+        me->update_icon_color_(17299u); // blue
       else
-        me->icon_color_ = 38066u; // grey
+        me->update_icon_color_(38066u); // grey
     }
     if (!me->icon_value_overridden_) {
       me->icon_value_ = get_value_or_default(SENSOR_OFF_ICON_MAP,
@@ -345,11 +391,11 @@ void StatefulPageItem::state_binary_sensor_fn(StatefulPageItem *me) {
 void StatefulPageItem::state_cover_fn(StatefulPageItem *me) {
   if (!me->icon_color_overridden_) {
     if (me->is_state(entity_state::closed))
-      me->icon_color_ = 17299u; // blue
+      me->update_icon_color_(17299u); // blue
     else if (me->is_state(entity_state::open))
-      me->icon_color_ = 64909u; // yellow
+      me->update_icon_color_(64909u); // yellow
     else 
-      me->icon_color_ = 38066u; // grey
+      me->update_icon_color_(38066u); // grey
   }
   
   if (!me->icon_value_overridden_) {
@@ -373,17 +419,17 @@ void StatefulPageItem::state_climate_fn(StatefulPageItem *me) {
   }
 
   if (!me->icon_color_overridden_) {
-    me->icon_color_ = 64512U;
+    me->update_icon_color_(64512U);
     if (state == entity_state::auto_ ||
         state == entity_state::heat_cool) {
-      me->icon_color_ = 1024U;
+      me->update_icon_color_(1024U);
     } else if (state == entity_state::off ||
         state == entity_state::fan_only) {
-      me->icon_color_ = 35921U;
+      me->update_icon_color_(35921U);
     } else if (state == entity_state::cool) {
-      me->icon_color_ = 11487U;
+      me->update_icon_color_(11487U);
     } else if (state == entity_state::dry) {
-      me->icon_color_ = 60897U;
+      me->update_icon_color_(60897U);
     }
   }
 }
@@ -394,11 +440,11 @@ void StatefulPageItem::state_media_fn(StatefulPageItem *me) {
   }
 
   if (me->is_state(entity_state::off)) {
-    me->icon_color_ = 17299u; // blue
+    me->update_icon_color_(17299u); // blue
   } else if (!me->is_state(entity_state::unavailable)) {
-    me->icon_color_ = 64909u; // yellow
+    me->update_icon_color_(64909u); // yellow
   } else {
-    me->icon_color_ = 38066u; // grey
+    me->update_icon_color_(38066u); // grey
   }
 }
 
@@ -412,7 +458,7 @@ void StatefulPageItem::state_alarm_fn(StatefulPageItem *me) {
   if (!me->icon_value_overridden_)
     me->icon_value_ = icon.value;
   if (!me->icon_color_overridden_)
-    me->icon_color_ = icon.color;
+    me->update_icon_color_(icon.color);
 }
 // todo: also change colour
 void StatefulPageItem::state_sun_fn(StatefulPageItem *me) {
@@ -441,7 +487,7 @@ void StatefulPageItem::state_weather_fn(StatefulPageItem *me) {
   if (!me->icon_value_overridden_)
     me->icon_value_ = icon.value;
   if (!me->icon_color_overridden_)
-    me->icon_color_ = icon.color;
+    me->update_icon_color_(icon.color);
 }
 
 } // namespace nspanel_lovelace
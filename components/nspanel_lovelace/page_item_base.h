@@ -6,7 +6,6 @@
 #include "page_item_visitor.h"
 #include "types.h"
 #include <array>
-#include <functional>
 #include <memory>
 #include <stdint.h>
 #include <string>
@@ -63,15 +62,24 @@ public:
   virtual void set_uuid(const std::string &uuid) { this->uuid_ = uuid; }
   
   bool get_render_invalid() { return this->render_invalid_; }
-  virtual void set_render_invalid() { this->render_invalid_ = true; }
+  void set_render_invalid() override;
   virtual const std::string &render();
 
+  // The page which renders this item, it is told when the item changes
+  Page *get_page() const { return this->page_; }
+  void set_page(Page *page) {
+    this->page_ = page;
+    std::string().swap(this->render_buffer_);
+    this->render_invalid_ = true;
+  }
+
 protected:
   std::string uuid_;
+  // output cache for items which aren't rendered by a page
   std::string render_buffer_;
   bool render_invalid_ = true;
+  Page *page_ = nullptr;
 
-  virtual uint16_t get_render_buffer_reserve_() const { return 5; }
   
   // output: internalName (uuid)
   std::string &render_(std::string &buffer) override;
@@ -92,8 +100,8 @@ public:
   const icon_char_t *get_icon_value() const { return this->icon_value_; }
   bool is_icon_value_overridden() const { return this->icon_value_overridden_; }
   uint16_t get_icon_color() const { return this->icon_color_; }
-  std::string get_icon_color_str() const {
-    return std::to_string(this->icon_color_);
+  std::string_view get_icon_color_str() const {
+    return {this->icon_color_str_, this->icon_color_str_length_};
   }
 
   virtual void set_icon_value(const icon_char_t *value);
@@ -109,9 +117,15 @@ protected:
   uint16_t icon_default_color_;
   const icon_char_t *icon_value_;
   uint16_t icon_color_;
+  // icon_color_ as text, it is rendered far more often than it changes
+  char icon_color_str_[5];
+  uint8_t icon_color_str_length_;
   bool icon_value_overridden_;
   bool icon_color_overridden_;
 
+  // Sets icon_color_ and updates its text
+  void update_icon_color_(const uint16_t color);
+
   // output: icon~iconColor
   std::string &render_(std::string &buffer) override;
 };
@@ -188,12 +202,17 @@ public:
 
   void accept(PageItemVisitor& visitor) override;
 
-  void on_entity_type_change(const char *type) override;
-  void on_entity_state_change(const std::string &state) override;
-  void on_entity_attribute_change(ha_attr_type attr, const std::string &value) override;
+  void on_entity_type_change(entity_kind kind) override;
+  void on_entity_changed(ha_attr_mask changed) override;
+
+  const std::string &render() override;
+  // Runs the state callback if the entity changed since it last ran.
+  // Call this before reading the icon, colour or value outside of render().
+  void update_state();
 
-  bool is_type(const char *type) const { return this->entity_->is_type(type); }
-  const char *get_type() const { return this ->entity_->get_type(); }
+  bool is_type(entity_kind kind) const { return this->entity_->is_type(kind); }
+  entity_kind get_type() const { return this->entity_->get_type(); }
+  const char *get_type_str() const { return this->entity_->get_type_str(); }
   const std::string &get_entity_id() const { return this->entity_->get_entity_id(); }
   bool is_state(const std::string &state) const { return this->entity_->is_state(state); }
   const std::string &get_state() const { return this->entity_->get_state(); }
@@ -206,10 +225,16 @@ public:
 protected:
   const std::shared_ptr<Entity> entity_;
   // A function which modifies the entity when the state changes
-  std::function<void(StatefulPageItem *)> on_state_callback_;
+  using state_callback_t = void (*)(StatefulPageItem *me);
+  state_callback_t on_state_callback_ = nullptr;
+  // set when the entity changes, on_state_callback_ runs on the next
+  // render so many updates between two renders only run it once
+  bool state_stale_ = true;
   const char *render_type_;
 
-  virtual void set_on_state_callback_(const char *type);
+  virtual void set_on_state_callback_(entity_kind kind);
+  static constexpr state_callback_t select_state_callback_(entity_kind kind);
+  static const std::array<state_callback_t, ENTITY_KIND_COUNT> state_callbacks_;
 
   static void state_on_off_fn(StatefulPageItem *me);
   static void state_binary_sensor_fn(StatefulPageItem *me);
@@ -223,7 +248,6 @@ protected:
 
   // output: type~internalName~icon~iconColor~
   std::string &render_(std::string &buffer) override;
-  uint16_t get_render_buffer_reserve_() const override;
 };
 
 } // namespace nspanel_lovelace
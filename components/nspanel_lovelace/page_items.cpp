@@ -19,34 +19,26 @@ namespace nspanel_lovelace {
 NavigationItem::NavigationItem(
     const std::string &uuid, const std::string &navigation_uuid) : 
     PageItem(uuid), PageItem_Icon(this, 65535u),
-    navigation_uuid_(navigation_uuid) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    navigation_uuid_(navigation_uuid) {}
 
 NavigationItem::NavigationItem(
     const std::string &uuid, const std::string &navigation_uuid, 
     const icon_char_t *icon_default_value) : 
     PageItem(uuid), PageItem_Icon(this, icon_default_value, 65535u),
-    navigation_uuid_(navigation_uuid) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    navigation_uuid_(navigation_uuid) {}
 
 NavigationItem::NavigationItem(
     const std::string &uuid, const std::string &navigation_uuid, 
     const uint16_t icon_default_color) : 
     PageItem(uuid), PageItem_Icon(this, icon_default_color),
-    navigation_uuid_(navigation_uuid) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    navigation_uuid_(navigation_uuid) {}
 
 NavigationItem::NavigationItem(
     const std::string &uuid, const std::string &navigation_uuid, 
     const icon_char_t *icon_default_value, const uint16_t icon_default_color) :
     PageItem(uuid),
     PageItem_Icon(this, icon_default_value, icon_default_color),
-    navigation_uuid_(navigation_uuid) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    navigation_uuid_(navigation_uuid) {}
 
 void NavigationItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
@@ -70,34 +62,26 @@ std::string &NavigationItem::render_(std::string &buffer) {
 
 StatusIconItem::StatusIconItem(
     const std::string &uuid, std::shared_ptr<Entity> entity) :
-    StatefulPageItem(uuid, std::move(entity)), alt_font_(false) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    StatefulPageItem(uuid, std::move(entity)), alt_font_(false) {}
 
 StatusIconItem::StatusIconItem(
     const std::string &uuid, std::shared_ptr<Entity> entity,
     const icon_char_t *icon_default_value) :
     StatefulPageItem(uuid, std::move(entity), icon_default_value),
-    alt_font_(false) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    alt_font_(false) {}
 
 StatusIconItem::StatusIconItem(
     const std::string &uuid, std::shared_ptr<Entity> entity,
     const uint16_t icon_default_color) :
     StatefulPageItem(uuid, std::move(entity), icon_default_color),
-    alt_font_(false) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    alt_font_(false) {}
 
 StatusIconItem::StatusIconItem(
     const std::string &uuid, std::shared_ptr<Entity> entity,
     const icon_char_t *icon_default_value, const uint16_t icon_default_color) :
     StatefulPageItem(uuid, std::move(entity),
       icon_default_value, icon_default_color),
-    alt_font_(false) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    alt_font_(false) {}
 
 void StatusIconItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
@@ -113,9 +97,7 @@ std::string &StatusIconItem::render_(std::string &buffer) {
 WeatherItem::WeatherItem(const std::string &uuid) :
     PageItem(uuid), PageItem_Icon(this, 63878u), // change the default icon color: #ff3131 (red)
     PageItem_DisplayName(this),
-    PageItem_Value(this, "0.0"), float_value_(0.0f) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    PageItem_Value(this, "0.0"), float_value_(0.0f) {}
 
 WeatherItem::WeatherItem(
     const std::string &uuid, const std::string &display_name, 
@@ -124,7 +106,6 @@ WeatherItem::WeatherItem(
     PageItem_DisplayName(this, display_name), 
     PageItem_Value(this, value), float_value_(0.0f) {
   this->set_icon_by_weather_condition(weather_condition);
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
 }
 
 void WeatherItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
@@ -133,7 +114,7 @@ void WeatherItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 void WeatherItem::set_icon_by_weather_condition(const std::string &condition) {
   Icon icon{};
   if (!try_get_value(WEATHER_ICON_MAP, icon, condition)) return;
-  this->icon_color_ = icon.color;
+  this->update_icon_color_(icon.color);
   this->icon_value_ = icon.value;
   this->set_render_invalid();
 }
@@ -142,7 +123,7 @@ bool WeatherItem::set_value(const std::string &value) {
   if (sscanf(value.c_str(), "%f", &this->float_value_) != 1)
     return false;
   this->value_ = value;
-  this->render_invalid_ = true;
+  this->set_render_invalid();
   return true;
 }
 
@@ -152,7 +133,7 @@ std::string &WeatherItem::render_(std::string &buffer) {
   PageItem_Icon::render_(buffer).append(1, SEPARATOR);
   PageItem_DisplayName::render_(buffer).append(1, SEPARATOR);
   // allow the value to be fomatted based on locale instead of using the raw string value
-  return buffer.append(esphome::str_snprintf("%.1f", 6, this->float_value_))
+  return buffer.append(num_str::fixed(this->float_value_, 1))
       .append(WeatherItem::temperature_unit);
 }
 
@@ -165,9 +146,7 @@ std::string WeatherItem::temperature_unit = "°C";
 AlarmButtonItem::AlarmButtonItem(const std::string &uuid,
     const char *action_type, const std::string &display_name) :
     PageItem(uuid), PageItem_DisplayName(this, display_name),
-    action_type_(action_type) {
-  this->render_buffer_.reserve(this->get_render_buffer_reserve_());
-}
+    action_type_(action_type) {}
 
 void AlarmButtonItem::accept(PageItemVisitor& visitor) { visitor.visit(*this); }
 
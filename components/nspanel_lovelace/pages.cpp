@@ -20,14 +20,9 @@ void Screensaver::set_icon_right(std::shared_ptr<StatusIconItem> right_icon) {
 }
 
 // output: weatherUpd~(5x)[type~internalName~icon~iconColor~displayName~value]
-std::string &Screensaver::render(std::string &buffer) {
+std::string &Screensaver::render_(std::string &buffer) {
   buffer.assign(this->get_render_instruction());
-
-  for (auto &item : this->items_) {
-    buffer.append(1, SEPARATOR).append(item->render());
-  }
-  
-  return buffer;
+  return this->render_items_(buffer);
 }
 
 // output: statusUpdate~icon1~icon1Color~icon2~icon2Color~icon1AltFont~icon2AltFont
@@ -149,5 +149,17 @@ static inline const char *get_translation(const std::string &key) {
   return get_translation(key.c_str());
 }
 
+// Looks up a key which isn't null terminated (e.g. an item of a list),
+// returns nullptr when there is no translation
+static inline const char *find_translation(const char *key, size_t length) {
+  char key_buffer[48];
+  if (length == 0 || length >= sizeof(key_buffer)) return nullptr;
+  std::memcpy(key_buffer, key, length);
+  key_buffer[length] = '\0';
+  const char *ret = nullptr;
+  if (!try_get_value(TRANSLATION_MAP, ret, key_buffer)) return nullptr;
+  return ret;
+}
+
 } // namespace nspanel_lovelace
 } // namespace esphome
\ No newline at end of file
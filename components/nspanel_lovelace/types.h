@@ -209,6 +209,21 @@ struct entity_state {
 
 };
 
+// rgb565 colours which are sent as text
+struct ui_color {
+  static constexpr const char* white = uint_chars<65535U>.data();
+  static constexpr const char* ha_dark = uint_chars<6371U>.data();
+  static constexpr const char* ha_blue = uint_chars<17299U>.data();
+  static constexpr const char* light_blue = uint_chars<1374U>.data();
+  static constexpr const char* orange = uint_chars<64704U>.data();
+  static constexpr const char* dark_orange = uint_chars<64512U>.data();
+  static constexpr const char* dark_green = uint_chars<1024U>.data();
+  static constexpr const char* muddy_grey = uint_chars<35921U>.data();
+  static constexpr const char* light_grey = uint_chars<52857U>.data();
+  static constexpr const char* cool_blue = uint_chars<11487U>.data();
+  static constexpr const char* light_orange = uint_chars<60897U>.data();
+};
+
 struct generic_type {
   static constexpr const char* enable = "enable";
   static constexpr const char* disable = "disable";
@@ -296,6 +311,50 @@ struct button_type {
   static constexpr const char* modeSelect = "mode-select";
 };
 
+// Sliders send a stream of button presses while they are being dragged,
+// the service calls for these are rate limited per control
+enum class control_type : uint8_t {
+  brightness,
+  color_temp,
+  color_wheel,
+  position,
+  tilt,
+  volume,
+  temperature,
+  temperature_high_low,
+  number,
+  unknown
+};
+
+static constexpr uint8_t CONTROL_TYPE_COUNT = static_cast<uint8_t>(control_type::unknown);
+
+// indexed by control_type
+static constexpr const char* control_type_button_types [] = {
+  button_type::brightnessSlider,
+  button_type::colorTempSlider,
+  button_type::colorWheel,
+  button_type::positionSlider,
+  button_type::tiltSlider,
+  button_type::volumeSlider,
+  button_type::tempUpd,
+  button_type::tempUpdHighLow,
+  button_type::numberSet
+};
+static_assert(sizeof(control_type_button_types) / sizeof(control_type_button_types[0]) == CONTROL_TYPE_COUNT, "");
+
+inline control_type get_control_type(const std::string &button_type) {
+  for (uint8_t i = 0; i < CONTROL_TYPE_COUNT; i++) {
+    if (button_type == control_type_button_types[i])
+      return static_cast<control_type>(i);
+  }
+  return control_type::unknown;
+}
+
+inline const char *to_button_type(control_type type) {
+  return type == control_type::unknown ? "" :
+      control_type_button_types[static_cast<uint8_t>(type)];
+}
+
 struct entity_type {
   static constexpr const char* scene = "scene";
   static constexpr const char* script = "script";
@@ -338,6 +397,117 @@ struct entity_type {
   static constexpr const char* delete_ = "delete";
 };
 
+// note: the order must match entity_kind_names
+enum class entity_kind : uint8_t {
+  unknown,
+  scene,
+  script,
+  light,
+  switch_,
+  input_boolean,
+  automation,
+  fan,
+  lock,
+  button,
+  input_button,
+  input_select,
+  number,
+  input_number,
+  vacuum,
+  timer,
+  person,
+  service,
+
+  cover,
+  sensor,
+  binary_sensor,
+  input_text,
+  text,
+  select,
+  alarm_control_panel,
+  media_player,
+  sun,
+  climate,
+  weather,
+
+  // internal (non HA) types
+  nav_up,
+  nav_prev,
+  nav_next,
+  uuid,
+  navigate,
+  navigate_uuid,
+  itext,
+  delete_,
+};
+
+static constexpr const char* entity_kind_names [] = {
+  "",
+  entity_type::scene,
+  entity_type::script,
+  entity_type::light,
+  entity_type::switch_,
+  entity_type::input_boolean,
+  entity_type::automation,
+  entity_type::fan,
+  entity_type::lock,
+  entity_type::button,
+  entity_type::input_button,
+  entity_type::input_select,
+  entity_type::number,
+  entity_type::input_number,
+  entity_type::vacuum,
+  entity_type::timer,
+  entity_type::person,
+  entity_type::service,
+
+  entity_type::cover,
+  entity_type::sensor,
+  entity_type::binary_sensor,
+  entity_type::input_text,
+  entity_type::text,
+  entity_type::select,
+  entity_type::alarm_control_panel,
+  entity_type::media_player,
+  entity_type::sun,
+  entity_type::climate,
+  entity_type::weather,
+
+  // internal (non HA) types
+  entity_type::nav_up,
+  entity_type::nav_prev,
+  entity_type::nav_next,
+  entity_type::uuid,
+  entity_type::navigate,
+  entity_type::navigate_uuid,
+  entity_type::itext,
+  entity_type::delete_,
+};
+
+static constexpr size_t ENTITY_KIND_COUNT =
+  static_cast<size_t>(entity_kind::delete_) + 1;
+
+static_assert(
+  (sizeof(entity_kind_names) / sizeof(*entity_kind_names)) == ENTITY_KIND_COUNT,
+  "entity_kind_names must have an entry for every entity_kind");
+
+// Builds a lookup table indexed by entity_kind at compile time,
+// select must be constexpr and is called once for every kind.
+template<class T>
+constexpr std::array<T, ENTITY_KIND_COUNT> make_entity_kind_table(
+    T (*select)(entity_kind)) {
+  std::array<T, ENTITY_KIND_COUNT> table{};
+  for (size_t i = 0; i < ENTITY_KIND_COUNT; i++)
+    table[i] = select(static_cast<entity_kind>(i));
+  return table;
+}
+
+inline const char *to_string(entity_kind kind) {
+  if ((size_t)kind >= (sizeof(entity_kind_names) / sizeof(*entity_kind_names)))
+    return nullptr;
+  return entity_kind_names[(uint8_t)kind];
+}
+
 struct entity_render_type {
   static constexpr const char* text = "text";
   static constexpr const char* shutter = "shutter";
@@ -449,6 +619,13 @@ static constexpr const char* page_type_names [] = {
   "popupLight",
 };
 
+static constexpr size_t PAGE_TYPE_COUNT =
+  static_cast<size_t>(page_type::popupLight) + 1;
+
+static_assert(
+  (sizeof(page_type_names) / sizeof(*page_type_names)) == PAGE_TYPE_COUNT,
+  "page_type_names must have an entry for every page_type");
+
 inline const char *to_string(page_type type) {
   if ((size_t)type >= (sizeof(page_type_names) / sizeof(*page_type_names)))
     return nullptr;
@@ -649,17 +826,68 @@ static constexpr const char* ha_attr_names [] = {
   "percentage_step",
 };
 
+// Bit set of ha_attr_type values, used to track which attributes changed
+using ha_attr_mask = uint64_t;
+static_assert(static_cast<size_t>(ha_attr_type::percentage_step) < 64,
+  "ha_attr_type no longer fits in ha_attr_mask");
+
+constexpr ha_attr_mask to_mask(ha_attr_type attr) {
+  return static_cast<ha_attr_mask>(1) << static_cast<uint8_t>(attr);
+}
+
 inline const char *to_string(ha_attr_type attr) {
   if ((size_t)attr >= (sizeof(ha_attr_names) / sizeof(*ha_attr_names)))
     return nullptr;
   return ha_attr_names[(uint8_t)attr];
 }
 
-inline ha_attr_type to_ha_attr(const std::string &attr) {
-  for (uint8_t i = 0; i < (sizeof(ha_attr_names) / sizeof(*ha_attr_names)); i++) {
-    if (attr == ha_attr_names[i]) return static_cast<ha_attr_type>(i);
+// Perfect hash of the HA attribute name to its ha_attr_type, the table is
+// generated at compile time from ha_attr_names.
+static constexpr uint32_t HA_ATTR_HASH_SEED = 0x81260D40;
+static constexpr uint8_t HA_ATTR_HASH_BITS = 7;
+
+constexpr uint8_t ha_attr_hash(const char *str, size_t length) {
+  return fnv1a_hash_slot(str, length, HA_ATTR_HASH_SEED, HA_ATTR_HASH_BITS);
+}
+
+struct ha_attr_hash_table {
+  ha_attr_type slots[1 << HA_ATTR_HASH_BITS];
+};
+
+constexpr ha_attr_hash_table make_ha_attr_hash_table() {
+  ha_attr_hash_table table{};
+  for (uint8_t i = 1; i < (sizeof(ha_attr_names) / sizeof(*ha_attr_names)); i++) {
+    table.slots[ha_attr_hash(ha_attr_names[i], const_strlen(ha_attr_names[i]))] =
+      static_cast<ha_attr_type>(i);
   }
-  return ha_attr_type::unknown;
+  return table;
+}
+
+static constexpr ha_attr_hash_table HA_ATTR_HASH_TABLE = make_ha_attr_hash_table();
+
+constexpr bool ha_attr_hash_is_perfect() {
+  for (uint8_t i = 1; i < (sizeof(ha_attr_names) / sizeof(*ha_attr_names)); i++) {
+    auto slot = ha_attr_hash(ha_attr_names[i], const_strlen(ha_attr_names[i]));
+    if (HA_ATTR_HASH_TABLE.slots[slot] != static_cast<ha_attr_type>(i)) return false;
+  }
+  return true;
+}
+static_assert(ha_attr_hash_is_perfect(),
+  "ha_attr_type hash collision, choose a different HA_ATTR_HASH_SEED");
+
+constexpr ha_attr_type to_ha_attr(const char *attr, size_t length) {
+  auto ha_attr = HA_ATTR_HASH_TABLE.slots[ha_attr_hash(attr, length)];
+  return ha_attr != ha_attr_type::unknown &&
+      const_str_equal(attr, length, ha_attr_names[static_cast<uint8_t>(ha_attr)])
+    ? ha_attr : ha_attr_type::unknown;
+}
+
+static_assert(to_ha_attr("brightness", 10) == ha_attr_type::brightness, "");
+static_assert(to_ha_attr("percentage_step", 15) == ha_attr_type::percentage_step, "");
+static_assert(to_ha_attr("brightnesss", 11) == ha_attr_type::unknown, "");
+
+inline ha_attr_type to_ha_attr(const std::string &attr) {
+  return to_ha_attr(attr.data(), attr.size());
 }
 
 struct ha_attr_color_mode {
@@ -1003,61 +1231,241 @@ static constexpr FrozenCharMap<const char *, 29> ENTITY_RENDER_TYPE_MAP {{
   std::pair<const char*, const char*>{entity_type::media_player, entity_render_type::media_pl},
 }};
 
-inline const char *get_entity_type(const std::string &entity_id) {
-  auto pos = entity_id.find('.');
-  if (pos == std::string::npos) {
-    if (entity_id == entity_type::delete_)
-      return entity_type::delete_;
-    return nullptr;
+// Perfect hash of the entity_id domain (the text before the first '.') to
+// its entity_kind. The table is generated at compile time from
+// entity_kind_names, the seed was chosen so no two domains share a slot.
+static constexpr uint32_t ENTITY_KIND_HASH_SEED = 0x811E4522;
+static constexpr uint8_t ENTITY_KIND_HASH_BITS = 6;
+
+constexpr uint8_t entity_kind_hash(const char *str, size_t length) {
+  return fnv1a_hash_slot(str, length, ENTITY_KIND_HASH_SEED, ENTITY_KIND_HASH_BITS);
+}
+
+// navigate.uuid and delete are not domains, they are special cased in get_entity_type
+constexpr bool entity_kind_hashed(entity_kind kind) {
+  return kind != entity_kind::unknown &&
+    kind != entity_kind::navigate_uuid &&
+    kind != entity_kind::delete_;
+}
+
+struct entity_kind_hash_table {
+  entity_kind slots[1 << ENTITY_KIND_HASH_BITS];
+};
+
+constexpr entity_kind_hash_table make_entity_kind_hash_table() {
+  entity_kind_hash_table table{};
+  for (uint8_t i = 0; i < (sizeof(entity_kind_names) / sizeof(*entity_kind_names)); i++) {
+    auto kind = static_cast<entity_kind>(i);
+    if (!entity_kind_hashed(kind)) continue;
+    table.slots[entity_kind_hash(entity_kind_names[i], const_strlen(entity_kind_names[i]))] = kind;
   }
-  
-	auto type = entity_id.substr(0, pos);
-
-	if (type == entity_type::light) return entity_type::light;
-  else if (type == entity_type::switch_) return entity_type::switch_;
-  else if (type == entity_type::input_boolean) return entity_type::input_boolean;
-  else if (type == entity_type::automation) return entity_type::automation;
-  else if (type == entity_type::fan) return entity_type::fan;
-  else if (type == entity_type::lock) return entity_type::lock;
-  else if (type == entity_type::button) return entity_type::button;
-  else if (type == entity_type::input_button) return entity_type::input_button;
-  else if (type == entity_type::input_select) return entity_type::input_select;
-  else if (type == entity_type::number) return entity_type::number;
-  else if (type == entity_type::input_number) return entity_type::input_number;
-  else if (type == entity_type::vacuum) return entity_type::vacuum;
-  else if (type == entity_type::timer) return entity_type::timer;
-  else if (type == entity_type::person) return entity_type::person;
-  else if (type == entity_type::service) return entity_type::service;
-  else if (type == entity_type::scene) return entity_type::scene;
-  else if (type == entity_type::script) return entity_type::script;
-
-  else if (type == entity_type::cover) return entity_type::cover;
-  else if (type == entity_type::sensor) return entity_type::sensor;
-  else if (type == entity_type::binary_sensor) return entity_type::binary_sensor;
-  else if (type == entity_type::text) return entity_type::text;
-  else if (type == entity_type::input_text) return entity_type::input_text;
-  else if (type == entity_type::select) return entity_type::select;
-  else if (type == entity_type::alarm_control_panel) return entity_type::alarm_control_panel;
-  else if (type == entity_type::media_player) return entity_type::media_player;
-  else if (type == entity_type::sun) return entity_type::sun;
-  else if (type == entity_type::climate) return entity_type::climate;
-  else if (type == entity_type::weather) return entity_type::weather;
+  return table;
+}
 
-  // internal (non HA) types
-  else if (type == entity_type::nav_up) return entity_type::nav_up;
-  else if (type == entity_type::nav_prev) return entity_type::nav_prev;
-  else if (type == entity_type::nav_next) return entity_type::nav_next;
-  else if (type == entity_type::uuid) return entity_type::uuid;
-  else if (type == entity_type::navigate) {
-    if (entity_id.length() > (pos + 5) &&
-      entity_id.substr(0, pos + 5) == entity_type::navigate_uuid)
-      return entity_type::navigate_uuid;
-    return entity_type::navigate;
+static constexpr entity_kind_hash_table ENTITY_KIND_HASH_TABLE = make_entity_kind_hash_table();
+
+constexpr bool entity_kind_hash_is_perfect() {
+  for (uint8_t i = 0; i < (sizeof(entity_kind_names) / sizeof(*entity_kind_names)); i++) {
+    auto kind = static_cast<entity_kind>(i);
+    if (!entity_kind_hashed(kind)) continue;
+    auto slot = entity_kind_hash(entity_kind_names[i], const_strlen(entity_kind_names[i]));
+    if (ENTITY_KIND_HASH_TABLE.slots[slot] != kind) return false;
   }
-  else if (type == entity_type::itext) return entity_type::itext;
-  
-  else return nullptr;
+  return true;
 }
+static_assert(entity_kind_hash_is_perfect(),
+  "entity_kind hash collision, choose a different ENTITY_KIND_HASH_SEED");
+
+// note: entity_id does not need to be null terminated
+constexpr entity_kind get_entity_type(const char *entity_id, size_t length) {
+  size_t pos = 0;
+  while (pos < length && entity_id[pos] != '.') pos++;
+
+  if (pos == length) {
+    return const_str_equal(entity_id, length, entity_type::delete_)
+      ? entity_kind::delete_ : entity_kind::unknown;
+  }
+
+  auto kind = ENTITY_KIND_HASH_TABLE.slots[entity_kind_hash(entity_id, pos)];
+  if (kind == entity_kind::unknown ||
+      !const_str_equal(entity_id, pos, entity_kind_names[static_cast<uint8_t>(kind)])) {
+    return entity_kind::unknown;
+  }
+
+  // navigate.uuid.{uuid}
+  if (kind == entity_kind::navigate && length > (pos + 5) &&
+      const_str_equal(entity_id, pos + 5, "navigate.uuid")) {
+    return entity_kind::navigate_uuid;
+  }
+  return kind;
+}
+
+static_assert(get_entity_type("light.kitchen", 13) == entity_kind::light, "");
+static_assert(get_entity_type("navigate.uuid.abc", 17) == entity_kind::navigate_uuid, "");
+static_assert(get_entity_type("navigate.abc", 12) == entity_kind::navigate, "");
+static_assert(get_entity_type("delete", 6) == entity_kind::delete_, "");
+static_assert(get_entity_type("lights.kitchen", 14) == entity_kind::unknown, "");
+
+inline entity_kind get_entity_type(const std::string &entity_id) {
+  return get_entity_type(entity_id.data(), entity_id.size());
+}
+
+// Where an entity is displayed, this decides which attributes are subscribed to
+enum class entity_usage : uint8_t {
+  none = 0,
+  // screensaver status icons (icon only)
+  status_icon = 1<<0,
+  // grid and media card items (icon only), these can open the detail popup
+  tile = 1<<1,
+  // entities and qr card items (icon and value), these can open the detail popup
+  row = 1<<2,
+  // the main entity of alarm, thermo and media cards
+  card = 1<<3,
+  all = 0xFF
+};
+constexpr entity_usage operator|(entity_usage a, entity_usage b) {
+  return static_cast<entity_usage>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+}
+constexpr entity_usage operator&(entity_usage a, entity_usage b) {
+  return static_cast<entity_usage>(static_cast<uint8_t>(a) & static_cast<uint8_t>(b));
+}
+
+// The Home Assistant attributes each entity_kind subscribes to, depending on
+// where the entity is used. ha_attr_type::state adds a state subscription.
+// Kinds which are not listed don't subscribe to anything.
+struct entity_subscription {
+  entity_kind kind;
+  entity_usage usage;
+  ha_attr_mask attrs;
+};
+
+static constexpr entity_usage ENTITY_USAGE_DETAIL =
+  entity_usage::tile | entity_usage::row;
+
+static constexpr entity_subscription ENTITY_SUBSCRIPTIONS[] = {
+  {entity_kind::light, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::light, ENTITY_USAGE_DETAIL,
+    to_mask(ha_attr_type::supported_color_modes) |
+    to_mask(ha_attr_type::color_mode) |
+    to_mask(ha_attr_type::min_mireds) |
+    to_mask(ha_attr_type::max_mireds) |
+    to_mask(ha_attr_type::color_temp) |
+    // need to subscribe to brightness to know if brightness is supported
+    to_mask(ha_attr_type::brightness) |
+    to_mask(ha_attr_type::effect_list)},
+  {entity_kind::switch_, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::input_boolean, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::input_text, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::text, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::automation, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::sun, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::vacuum, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::lock, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::person, entity_usage::all, to_mask(ha_attr_type::state)},
+  // icons are based on state and device_class
+  {entity_kind::sensor, entity_usage::all,
+    to_mask(ha_attr_type::state) |
+    to_mask(ha_attr_type::device_class)},
+  {entity_kind::sensor, entity_usage::row,
+    to_mask(ha_attr_type::unit_of_measurement)},
+  {entity_kind::binary_sensor, entity_usage::all,
+    to_mask(ha_attr_type::state) |
+    to_mask(ha_attr_type::device_class)},
+  {entity_kind::binary_sensor, entity_usage::row,
+    to_mask(ha_attr_type::unit_of_measurement)},
+  {entity_kind::cover, entity_usage::all,
+    to_mask(ha_attr_type::state) |
+    to_mask(ha_attr_type::device_class)},
+  {entity_kind::cover, ENTITY_USAGE_DETAIL,
+    to_mask(ha_attr_type::supported_features) |
+    to_mask(ha_attr_type::current_position) |
+    to_mask(ha_attr_type::current_tilt_position)},
+  {entity_kind::alarm_control_panel, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::alarm_control_panel, entity_usage::card,
+    to_mask(ha_attr_type::code_arm_required) |
+    to_mask(ha_attr_type::open_sensors)},
+  {entity_kind::timer, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::timer, ENTITY_USAGE_DETAIL,
+    to_mask(ha_attr_type::editable) |
+    to_mask(ha_attr_type::duration) |
+    to_mask(ha_attr_type::remaining) |
+    to_mask(ha_attr_type::finishes_at)},
+  {entity_kind::climate, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::climate, entity_usage::row | entity_usage::card,
+    to_mask(ha_attr_type::temperature) |
+    to_mask(ha_attr_type::current_temperature)},
+  // the detail popup shows each list of modes with the current one
+  {entity_kind::climate, ENTITY_USAGE_DETAIL | entity_usage::card,
+    to_mask(ha_attr_type::preset_modes) |
+    to_mask(ha_attr_type::preset_mode) |
+    to_mask(ha_attr_type::swing_modes) |
+    to_mask(ha_attr_type::swing_mode) |
+    to_mask(ha_attr_type::fan_modes) |
+    to_mask(ha_attr_type::fan_mode)},
+  {entity_kind::climate, entity_usage::card,
+    to_mask(ha_attr_type::target_temp_high) |
+    to_mask(ha_attr_type::target_temp_low) |
+    to_mask(ha_attr_type::target_temp_step) |
+    to_mask(ha_attr_type::min_temp) |
+    to_mask(ha_attr_type::max_temp) |
+    to_mask(ha_attr_type::hvac_action) |
+    to_mask(ha_attr_type::hvac_modes)},
+  // the icon is based on media_content_type
+  {entity_kind::media_player, entity_usage::all,
+    to_mask(ha_attr_type::state) |
+    to_mask(ha_attr_type::media_content_type)},
+  {entity_kind::media_player, ENTITY_USAGE_DETAIL | entity_usage::card,
+    to_mask(ha_attr_type::source_list)},
+  {entity_kind::media_player, entity_usage::card,
+    to_mask(ha_attr_type::supported_features) |
+    to_mask(ha_attr_type::media_title) |
+    to_mask(ha_attr_type::media_artist) |
+    to_mask(ha_attr_type::volume_level) |
+    to_mask(ha_attr_type::shuffle)},
+  {entity_kind::select, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::select, ENTITY_USAGE_DETAIL, to_mask(ha_attr_type::options)},
+  {entity_kind::input_select, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::input_select, ENTITY_USAGE_DETAIL, to_mask(ha_attr_type::options)},
+  {entity_kind::number, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::number, entity_usage::row,
+    to_mask(ha_attr_type::min) |
+    to_mask(ha_attr_type::max)},
+  {entity_kind::input_number, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::input_number, entity_usage::row,
+    to_mask(ha_attr_type::min) |
+    to_mask(ha_attr_type::max)},
+  {entity_kind::weather, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::weather, entity_usage::row,
+    to_mask(ha_attr_type::temperature) |
+    to_mask(ha_attr_type::temperature_unit)},
+  {entity_kind::fan, entity_usage::all, to_mask(ha_attr_type::state)},
+  {entity_kind::fan, ENTITY_USAGE_DETAIL,
+    to_mask(ha_attr_type::percentage_step) |
+    to_mask(ha_attr_type::percentage) |
+    to_mask(ha_attr_type::preset_modes) |
+    to_mask(ha_attr_type::preset_mode)},
+};
+
+// Collects the attributes from table which an entity of the given kind needs
+// when it is displayed as described by usage.
+template<size_t N>
+constexpr ha_attr_mask get_entity_subscriptions(
+    const entity_subscription (&table)[N], entity_kind kind, entity_usage usage) {
+  ha_attr_mask attrs = 0;
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].kind == kind && (table[i].usage & usage) != entity_usage::none) {
+      attrs |= table[i].attrs;
+    }
+  }
+  return attrs;
+}
+
+static_assert(get_entity_subscriptions(ENTITY_SUBSCRIPTIONS,
+  entity_kind::unknown, entity_usage::all) == 0, "");
+static_assert(get_entity_subscriptions(ENTITY_SUBSCRIPTIONS,
+  entity_kind::light, entity_usage::status_icon) == to_mask(ha_attr_type::state), "");
+static_assert((get_entity_subscriptions(ENTITY_SUBSCRIPTIONS,
+  entity_kind::media_player, entity_usage::tile) & to_mask(ha_attr_type::media_title)) == 0, "");
 
 } // namespace nspanel_lovelace
 } // namespace esphome
\ No newline at end of file
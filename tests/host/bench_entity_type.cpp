@@ -0,0 +1,100 @@
+// get_entity_type() against the chain of string compares it replaced
+
+#include <array>
+#include <string>
+
+#include "harness.h"
+#include "types.h"
+
+using namespace nspanel_test;
+using namespace esphome::nspanel_lovelace;
+
+namespace {
+
+// get_entity_type() before the perfect hash, kept for comparison
+entity_kind get_entity_type_linear(const std::string &entity_id) {
+  auto pos = entity_id.find('.');
+  if (pos == std::string::npos) {
+    if (entity_id == entity_type::delete_)
+      return entity_kind::delete_;
+    return entity_kind::unknown;
+  }
+
+  auto type = entity_id.substr(0, pos);
+
+  if (type == entity_type::light) return entity_kind::light;
+  else if (type == entity_type::switch_) return entity_kind::switch_;
+  else if (type == entity_type::input_boolean) return entity_kind::input_boolean;
+  else if (type == entity_type::automation) return entity_kind::automation;
+  else if (type == entity_type::fan) return entity_kind::fan;
+  else if (type == entity_type::lock) return entity_kind::lock;
+  else if (type == entity_type::button) return entity_kind::button;
+  else if (type == entity_type::input_button) return entity_kind::input_button;
+  else if (type == entity_type::input_select) return entity_kind::input_select;
+  else if (type == entity_type::number) return entity_kind::number;
+  else if (type == entity_type::input_number) return entity_kind::input_number;
+  else if (type == entity_type::vacuum) return entity_kind::vacuum;
+  else if (type == entity_type::timer) return entity_kind::timer;
+  else if (type == entity_type::person) return entity_kind::person;
+  else if (type == entity_type::service) return entity_kind::service;
+  else if (type == entity_type::scene) return entity_kind::scene;
+  else if (type == entity_type::script) return entity_kind::script;
+
+  else if (type == entity_type::cover) return entity_kind::cover;
+  else if (type == entity_type::sensor) return entity_kind::sensor;
+  else if (type == entity_type::binary_sensor) return entity_kind::binary_sensor;
+  else if (type == entity_type::text) return entity_kind::text;
+  else if (type == entity_type::input_text) return entity_kind::input_text;
+  else if (type == entity_type::select) return entity_kind::select;
+  else if (type == entity_type::alarm_control_panel) return entity_kind::alarm_control_panel;
+  else if (type == entity_type::media_player) return entity_kind::media_player;
+  else if (type == entity_type::sun) return entity_kind::sun;
+  else if (type == entity_type::climate) return entity_kind::climate;
+  else if (type == entity_type::weather) return entity_kind::weather;
+
+  // internal (non HA) types
+  else if (type == entity_type::nav_up) return entity_kind::nav_up;
+  else if (type == entity_type::nav_prev) return entity_kind::nav_prev;
+  else if (type == entity_type::nav_next) return entity_kind::nav_next;
+  else if (type == entity_type::uuid) return entity_kind::uuid;
+  else if (type == entity_type::navigate) {
+    if (entity_id.length() > (pos + 5) &&
+      entity_id.substr(0, pos + 5) == entity_type::navigate_uuid)
+      return entity_kind::navigate_uuid;
+    return entity_kind::navigate;
+  }
+  else if (type == entity_type::itext) return entity_kind::itext;
+
+  else return entity_kind::unknown;
+}
+
+// what the panel looks up at runtime: button presses arrive with uuids,
+// the rest are the entity ids of the items being rendered
+const std::array<std::string, 10> ENTITY_IDS{{
+  "uuid.12", "light.kitchen_ceiling", "sensor.outside_temperature",
+  "binary_sensor.front_door", "climate.living_room", "media_player.lounge",
+  "alarm_control_panel.home", "navigate.uuid.grid2", "weather.home", "delete",
+}};
+
+} // namespace
+
+int main() {
+  for (auto &entity_id : ENTITY_IDS) {
+    CHECK(get_entity_type(entity_id) == get_entity_type_linear(entity_id));
+  }
+  CHECK(get_entity_type("iText.x") == get_entity_type_linear("iText.x"));
+  CHECK(get_entity_type("unknown_domain.x") == entity_kind::unknown);
+
+  // the result is summed so the calls can't be optimised away
+  size_t i = 0;
+  volatile unsigned sink = 0;
+  bench("get_entity_type/linear", [&]() {
+    sink += static_cast<unsigned>(get_entity_type_linear(ENTITY_IDS[i++ % ENTITY_IDS.size()]));
+    return size_t{0};
+  });
+  bench("get_entity_type/hash", [&]() {
+    sink += static_cast<unsigned>(get_entity_type(ENTITY_IDS[i++ % ENTITY_IDS.size()]));
+    return size_t{0};
+  });
+  return finish();
+}
@@ -0,0 +1,61 @@
+// num_str against the std::to_string and snprintf calls it replaced in
+// the renderers. Every variant appends to a reused buffer, as they do.
+
+#include <cstdio>
+#include <string>
+
+#include "harness.h"
+#include "helpers.h"
+
+using namespace nspanel_test;
+using namespace esphome::nspanel_lovelace;
+
+namespace {
+
+std::string fixed_printf(float value, int decimals) {
+  char str[16];
+  snprintf(str, sizeof(str), "%.*f", decimals, value);
+  return str;
+}
+
+} // namespace
+
+int main() {
+  // same output, except at exact halves which num_str rounds away from zero
+  for (uint32_t value : {0u, 7u, 42u, 65535u, 4294967295u}) {
+    CHECK(std::string(num_str(value)) == std::to_string(value));
+  }
+  for (int32_t value : {-2147483647 - 1, -1, 0, 12345}) {
+    CHECK(std::string(num_str(value)) == std::to_string(value));
+  }
+  for (float value : {0.0f, -0.4f, 21.3f, -7.5f, 1013.7f}) {
+    CHECK(std::string(num_str::fixed(value, 1)) == fixed_printf(value, 1));
+  }
+  CHECK(std::string(num_str::fixed(215, 1)) == "21.5");
+  CHECK(std::string(num_str::fixed(-5, 2)) == "-0.05");
+
+  std::string buffer;
+  uint16_t colour = 0;
+  float temperature = 0.0f;
+  bench("u16/to_string", [&]() {
+    buffer.clear();
+    buffer.append(std::to_string(colour += 97));
+    return buffer.size();
+  });
+  bench("u16/num_str", [&]() {
+    buffer.clear();
+    buffer.append(num_str(static_cast<uint32_t>(colour += 97)));
+    return buffer.size();
+  });
+  bench("float_1dp/snprintf", [&]() {
+    buffer.clear();
+    buffer.append(fixed_printf(temperature += 0.7f, 1));
+    return buffer.size();
+  });
+  bench("float_1dp/num_str", [&]() {
+    buffer.clear();
+    buffer.append(num_str::fixed(temperature += 0.7f, 1));
+    return buffer.size();
+  });
+  return finish();
+}
@@ -0,0 +1,91 @@
+// Render cost of every page type and popup detail page.
+//
+//   render_full/<page>    page output rebuilt from scratch
+//   render_cached/<page>  page output copied from the render cache
+//   entity_update/<page>  a Home Assistant state change of one item on the
+//                         current page, up to the frame written to the UART
+//   popup/<kind>          detail page update, up to the frame written
+
+#include <string>
+
+#include "fixtures.h"
+
+using namespace nspanel_test;
+
+namespace {
+
+void bench_page(TestPanel &panel, Page *page, const char *name,
+    const char *entity_id, const char *on, const char *off) {
+  std::string buffer;
+  std::string label;
+
+  label.assign("render_full/").append(name);
+  bench(label.c_str(), [&]() {
+    page->set_render_invalid();
+    return page->render(buffer).size();
+  });
+
+  label.assign("render_cached/").append(name);
+  bench(label.c_str(), [&]() { return page->render(buffer).size(); });
+
+  // rendering the page makes its entities visible
+  for (size_t i = 0; i < panel.pages_.size(); i++) {
+    if (panel.pages_[i].get() == page) panel.render_page_(i);
+  }
+  panel.drain();
+  uart_tx_clear();
+  bool state = false;
+  label.assign("entity_update/").append(name);
+  bench(label.c_str(), [&]() {
+    state = !state;
+    ha_send(entity_id, "", state ? on : off);
+    advance_ms(ENTITY_FLUSH_MAX_DELAY);
+    panel.drain();
+    size_t bytes = uart_tx().size();
+    uart_tx_clear();
+    return bytes;
+  });
+}
+
+void bench_popup(TestPanel &panel, const char *name,
+    void (TestPanel::*render)(StatefulPageItem *), StatefulPageItem *item) {
+  std::string label("popup/");
+  label.append(name);
+  bench(label.c_str(), [&]() {
+    (panel.*render)(item);
+    panel.drain();
+    size_t bytes = uart_tx().size();
+    uart_tx_clear();
+    return bytes;
+  });
+}
+
+} // namespace
+
+int main() {
+  TestPanel panel;
+  auto pages = build_panel(panel);
+  start_panel(panel);
+
+  bench_page(panel, pages.screensaver, "screensaver", "switch.heater", "on", "off");
+  bench_page(panel, pages.grid, "cardGrid", "switch.lamp", "on", "off");
+  bench_page(panel, pages.grid2, "cardGrid2", "light.room_0", "on", "off");
+  bench_page(panel, pages.entities, "cardEntities", "sensor.temperature", "21.3", "21.4");
+  bench_page(panel, pages.thermo, "cardThermo", "climate.living", "heat", "auto");
+  bench_page(panel, pages.media, "cardMedia", "media_player.lounge", "playing", "paused");
+  bench_page(panel, pages.qr, "cardQR", "sensor.guest_ssid", "guest", "visitor");
+  bench_page(panel, pages.alarm, "cardAlarm", "alarm_control_panel.home", "disarmed", "armed_home");
+
+  auto grid_item = [&pages](size_t index) {
+    return pages.grid->get_item<StatefulPageItem>(index);
+  };
+  bench_popup(panel, "light", &TestPanel::render_light_detail_update_, grid_item(0));
+  bench_popup(panel, "cover", &TestPanel::render_cover_detail_update_, grid_item(2));
+  bench_popup(panel, "fan", &TestPanel::render_fan_detail_update_, grid_item(3));
+  bench_popup(panel, "input_select", &TestPanel::render_input_select_detail_update_, grid_item(4));
+  bench_popup(panel, "timer", &TestPanel::render_timer_detail_update_, grid_item(5));
+  bench_popup(panel, "climate", &TestPanel::render_climate_detail_update_,
+    pages.entities->get_item<StatefulPageItem>(2));
+
+  return finish();
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+// A panel with a page of every type, built the same way as the code
+// __init__.py generates from the yaml config, and the Home Assistant
+// states to go with it.
+
+#include <memory>
+#include <string>
+
+#include "harness.h"
+#include "card_items.h"
+#include "cards.h"
+#include "page_items.h"
+#include "pages.h"
+
+namespace nspanel_test {
+
+using namespace esphome::nspanel_lovelace;
+
+struct fixture_pages {
+  Screensaver *screensaver;
+  GridCard *grid;
+  GridCard *grid2;
+  EntitiesCard *entities;
+  ThermoCard *thermo;
+  MediaCard *media;
+  QRCard *qr;
+  AlarmCard *alarm;
+};
+
+inline void set_nav(Card *card, const std::string &prev_uuid,
+    const std::string &next_uuid) {
+  static int uuid = 900;
+  std::unique_ptr<NavigationItem> left(new NavigationItem(
+    std::to_string(uuid++), prev_uuid, icon_t::arrow_left_bold));
+  std::unique_ptr<NavigationItem> right(new NavigationItem(
+    std::to_string(uuid++), next_uuid, icon_t::arrow_right_bold));
+  card->set_nav_left(left);
+  card->set_nav_right(right);
+}
+
+// Adds the pages, must be called before setup()
+inline fixture_pages build_panel(TestPanel &panel) {
+  fixture_pages p{};
+  auto tile = [&panel](const char *entity_id) {
+    return panel.create_entity(entity_id, entity_usage::tile);
+  };
+  auto row = [&panel](const char *entity_id) {
+    return panel.create_entity(entity_id, entity_usage::row);
+  };
+  auto card = [&panel](const char *entity_id) {
+    return panel.create_entity(entity_id, entity_usage::card);
+  };
+
+  panel.set_weather_entity_id("weather.home");
+  p.screensaver = panel.insert_page<Screensaver>(0, "ss");
+  p.screensaver->set_icon_left(std::make_shared<StatusIconItem>("1",
+    panel.create_entity("binary_sensor.door", entity_usage::status_icon),
+    icon_t::alert_circle_outline));
+  p.screensaver->set_icon_right(std::make_shared<StatusIconItem>("2",
+    panel.create_entity("switch.heater", entity_usage::status_icon),
+    icon_t::alert_circle_outline, 17299u));
+  p.screensaver->add_item_range({
+    std::make_shared<WeatherItem>("3"), std::make_shared<WeatherItem>("4"),
+    std::make_shared<WeatherItem>("5"), std::make_shared<WeatherItem>("6"),
+    std::make_shared<WeatherItem>("7")});
+
+  p.grid = panel.create_page<GridCard>("grid", "Grid", 10);
+  p.grid->add_item(std::make_shared<GridCardEntityItem>("10", tile("light.kitchen"), "Kitchen"));
+  p.grid->add_item(std::make_shared<GridCardEntityItem>("11", tile("switch.lamp"), "Lamp"));
+  p.grid->add_item(std::make_shared<GridCardEntityItem>("12", tile("cover.blinds"), "Blinds"));
+  p.grid->add_item(std::make_shared<GridCardEntityItem>("13", tile("fan.ceiling"), "Ceiling"));
+  p.grid->add_item(std::make_shared<GridCardEntityItem>("14", tile("input_select.mode"), "Mode"));
+  p.grid->add_item(std::make_shared<GridCardEntityItem>("15", tile("timer.egg"), "Egg"));
+
+  p.grid2 = panel.create_page<GridCard>("grid2", "Grid 2", 10);
+  p.grid2->set_render_type(page_type::cardGrid2);
+  for (int i = 0; i < 8; i++) {
+    auto entity_id = "light.room_" + std::to_string(i);
+    p.grid2->add_item(std::make_shared<GridCardEntityItem>(
+      std::to_string(20 + i), tile(entity_id.c_str()), "Room " + std::to_string(i)));
+  }
+
+  p.entities = panel.create_page<EntitiesCard>("entities", "Entities", 10);
+  p.entities->add_item(std::make_shared<EntitiesCardEntityItem>("30", row("sensor.temperature"), "Temperature"));
+  p.entities->add_item(std::make_shared<EntitiesCardEntityItem>("31", row("number.volume"), "Volume"));
+  p.entities->add_item(std::make_shared<EntitiesCardEntityItem>("32", row("climate.bedroom"), "Bedroom"));
+  p.entities->add_item(std::make_shared<EntitiesCardEntityItem>("33", row("lock.front"), "Front door"));
+
+  p.thermo = panel.create_page<ThermoCard>("thermo", card("climate.living"), "Thermostat", 10);
+  p.media = panel.create_page<MediaCard>("media", card("media_player.lounge"), "Media", 10);
+
+  p.qr = panel.create_page<QRCard>("qr", "Guest WiFi");
+  p.qr->set_qr_text("WIFI:S:guest;T:WPA;P:password;;");
+  p.qr->add_item(std::make_shared<EntitiesCardEntityItem>("40", row("sensor.guest_ssid"), "Name"));
+
+  p.alarm = panel.create_page<AlarmCard>("alarm", card("alarm_control_panel.home"), "Alarm", 10);
+  p.alarm->add_arm_button(alarm_arm_action::arm_home);
+  p.alarm->add_arm_button(alarm_arm_action::arm_away);
+
+  set_nav(p.grid, "alarm", "grid2");
+  set_nav(p.grid2, "grid", "entities");
+  set_nav(p.entities, "grid2", "thermo");
+  set_nav(p.thermo, "entities", "media");
+  set_nav(p.media, "thermo", "qr");
+  set_nav(p.qr, "media", "alarm");
+  set_nav(p.alarm, "qr", "grid");
+  return p;
+}
+
+// Sends every state the fixture entities subscribe to
+inline void send_fixture_states() {
+  ha_send("weather.home", "", "sunny");
+  ha_send("weather.home", "temperature", "21.5");
+  ha_send("weather.home", "temperature_unit", "°C");
+  ha_send("binary_sensor.door", "", "off");
+  ha_send("switch.heater", "", "on");
+
+  ha_send("light.kitchen", "", "on");
+  ha_send("light.kitchen", "brightness", "128");
+  ha_send("light.kitchen", "supported_color_modes", "['color_temp', 'rgb']");
+  ha_send("light.kitchen", "color_mode", "color_temp");
+  // the range comes first, color_temp is scaled with it
+  ha_send("light.kitchen", "min_mireds", "153");
+  ha_send("light.kitchen", "max_mireds", "500");
+  ha_send("light.kitchen", "color_temp", "300");
+  ha_send("switch.lamp", "", "off");
+  ha_send("cover.blinds", "", "open");
+  ha_send("cover.blinds", "current_position", "60");
+  ha_send("cover.blinds", "supported_features", "15");
+  ha_send("fan.ceiling", "", "on");
+  ha_send("fan.ceiling", "percentage", "50");
+  ha_send("fan.ceiling", "percentage_step", "25");
+  ha_send("fan.ceiling", "preset_modes", "['auto', 'sleep']");
+  ha_send("fan.ceiling", "preset_mode", "auto");
+  ha_send("input_select.mode", "", "Home");
+  ha_send("input_select.mode", "options", "['Home', 'Away', 'Night']");
+  ha_send("timer.egg", "", "idle");
+  ha_send("timer.egg", "duration", "0:05:00");
+  ha_send("timer.egg", "editable", "true");
+  for (int i = 0; i < 8; i++) {
+    ha_send("light.room_" + std::to_string(i), "", i % 2 ? "on" : "off");
+  }
+
+  ha_send("sensor.temperature", "", "21.3");
+  ha_send("sensor.temperature", "unit_of_measurement", "°C");
+  ha_send("number.volume", "", "40.0");
+  ha_send("number.volume", "min", "0");
+  ha_send("number.volume", "max", "100");
+  ha_send("climate.bedroom", "", "heat");
+  ha_send("climate.bedroom", "temperature", "19.5");
+  ha_send("climate.bedroom", "current_temperature", "18.9");
+  ha_send("lock.front", "", "locked");
+
+  ha_send("climate.living", "", "heat");
+  ha_send("climate.living", "temperature", "21");
+  ha_send("climate.living", "current_temperature", "20.4");
+  ha_send("climate.living", "min_temp", "7");
+  ha_send("climate.living", "max_temp", "35");
+  ha_send("climate.living", "target_temp_step", "0.5");
+  ha_send("climate.living", "hvac_modes", "['off', 'heat', 'auto']");
+  ha_send("climate.living", "hvac_action", "heating");
+  ha_send("climate.living", "preset_modes", "['eco', 'comfort']");
+  ha_send("climate.living", "preset_mode", "eco");
+  ha_send("media_player.lounge", "", "playing");
+  ha_send("media_player.lounge", "media_title", "Song");
+  ha_send("media_player.lounge", "media_artist", "Artist");
+  ha_send("media_player.lounge", "volume_level", "0.4");
+  ha_send("media_player.lounge", "supported_features", "152463");
+  ha_send("sensor.guest_ssid", "", "guest");
+  ha_send("alarm_control_panel.home", "", "disarmed");
+  ha_send("alarm_control_panel.home", "code_arm_required", "false");
+}
+
+// setup(), the display startup event and the initial states, leaves the
+// panel on the screensaver with nothing left to send
+inline void start_panel(TestPanel &panel) {
+  panel.setup();
+  uart_rx_event("event,startup,53,eu");
+  panel.drain();
+  send_fixture_states();
+  // let the entity flush delay pass so the states are applied
+  advance_ms(2000);
+  panel.drain();
+  uart_tx_clear();
+}
+
+} // namespace nspanel_test
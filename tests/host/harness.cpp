@@ -0,0 +1,431 @@
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <new>
+
+#include "esphome/components/api/custom_api_device.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+#include "esphome/core/time.h"
+#include "esphome/components/time/real_time_clock.h"
+#include "translations.h"
+
+// ---- heap allocation accounting ----
+
+static size_t g_alloc_count = 0;
+static size_t g_alloc_bytes = 0;
+
+void *operator new(size_t size) {
+  g_alloc_count++;
+  g_alloc_bytes += size;
+  void *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) std::abort();
+  return ptr;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+struct scheduled {
+  const esphome::Component *owner;
+  std::string name;
+  uint32_t due;
+  uint32_t interval;
+  std::function<void()> fn;
+};
+
+struct subscription {
+  std::string entity_id;
+  std::string attribute;
+  std::function<void(std::string)> fn;
+};
+
+uint32_t g_now = 0;
+std::vector<scheduled> g_scheduled;
+std::string g_tx;
+std::string g_rx;
+std::vector<subscription> g_subscriptions;
+std::vector<esphome::api::HomeassistantServiceResponse> g_service_calls;
+bool g_track_reads = false;
+std::map<const esphome::nspanel_lovelace::Entity *,
+    esphome::nspanel_lovelace::ha_attr_mask> g_attribute_reads;
+bool g_log_capture = false;
+std::vector<std::string> g_log_lines;
+int g_check_failures = 0;
+
+void schedule(const esphome::Component *owner, const std::string &name,
+    uint32_t delay, uint32_t interval, std::function<void()> &&fn) {
+  if (!name.empty()) {
+    g_scheduled.erase(std::remove_if(g_scheduled.begin(), g_scheduled.end(),
+      [owner, &name](const scheduled &s) { return s.owner == owner && s.name == name; }),
+      g_scheduled.end());
+  }
+  g_scheduled.push_back({owner, name, g_now + delay, interval, std::move(fn)});
+}
+
+bool cancel(const esphome::Component *owner, const std::string &name) {
+  auto it = std::remove_if(g_scheduled.begin(), g_scheduled.end(),
+    [owner, &name](const scheduled &s) { return s.owner == owner && s.name == name; });
+  bool found = it != g_scheduled.end();
+  g_scheduled.erase(it, g_scheduled.end());
+  return found;
+}
+
+} // namespace
+
+// ---- ESPHome stubs ----
+
+namespace esphome {
+
+namespace setup_priority {
+const float DATA = 600.0f;
+}
+
+uint32_t millis() { return g_now; }
+// wall time, only used for the render statistics
+uint32_t micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+void delay(uint32_t ms) { g_now += ms; }
+
+void esp_log_printf_(char level, const char *tag, const char *fmt, ...) {
+  static const bool print = std::getenv("NSPANEL_TEST_LOG") != nullptr;
+  if (!g_log_capture && !print) return;
+  char line[512];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (print) fprintf(stderr, "[%c][%s] %s\n", level, tag, line);
+  if (g_log_capture) g_log_lines.emplace_back(line);
+}
+
+std::string to_string(int value) { return std::to_string(value); }
+std::string to_string(long value) { return std::to_string(value); }
+std::string to_string(long long value) { return std::to_string(value); }
+std::string to_string(unsigned value) { return std::to_string(value); }
+std::string to_string(unsigned long value) { return std::to_string(value); }
+std::string to_string(unsigned long long value) { return std::to_string(value); }
+std::string to_string(float value) { return str_snprintf("%.1f", 32, value); }
+std::string to_string(double value) { return str_snprintf("%.1f", 32, value); }
+
+std::string str_snprintf(const char *fmt, size_t len, ...) {
+  std::string str(len, '\0');
+  va_list args;
+  va_start(args, len);
+  size_t out_length = vsnprintf(&str[0], len + 1, fmt, args);
+  va_end(args);
+  str.resize(std::min(out_length, len));
+  return str;
+}
+bool str_startswith(const std::string &str, const std::string &start) {
+  return str.rfind(start, 0) == 0;
+}
+bool str_endswith(const std::string &str, const std::string &end) {
+  return str.size() >= end.size() &&
+    str.compare(str.size() - end.size(), end.size(), end) == 0;
+}
+std::string format_hex(const std::vector<uint8_t> &data) {
+  std::string ret;
+  char hex[3];
+  for (auto b : data) {
+    snprintf(hex, sizeof(hex), "%02x", b);
+    ret += hex;
+  }
+  return ret;
+}
+uint16_t crc16(const uint8_t *data, uint16_t len, uint16_t crc,
+    uint16_t reverse_poly, bool refin, bool refout) {
+  if (refin) crc ^= 0xffff;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 1) ? (crc >> 1) ^ reverse_poly : crc >> 1;
+  }
+  return refout ? (crc ^ 0xffff) : crc;
+}
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+uint32_t Component::get_object_id_hash() { return 0; }
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  schedule(this, name, interval, interval, std::move(f));
+}
+void Component::set_interval(uint32_t interval, std::function<void()> &&f) {
+  schedule(this, "", interval, interval, std::move(f));
+}
+bool Component::cancel_interval(const std::string &name) { return cancel(this, name); }
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  schedule(this, name, timeout, 0, std::move(f));
+}
+void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) {
+  schedule(this, "", timeout, 0, std::move(f));
+}
+bool Component::cancel_timeout(const std::string &name) { return cancel(this, name); }
+void Component::defer(std::function<void()> &&f) { schedule(this, "", 0, 0, std::move(f)); }
+
+// the clock never syncs, so the panel doesn't show a time
+std::string ESPTime::strftime(const std::string &format) { return ""; }
+bool ESPTime::is_valid() const { return false; }
+ESPTime ESPTime::from_epoch_utc(time_t epoch) { return ESPTime{}; }
+namespace time {
+ESPTime RealTimeClock::now() { return ESPTime{}; }
+void RealTimeClock::add_on_time_sync_callback(std::function<void()> &&cb) {}
+} // namespace time
+
+Application App;
+void Application::feed_wdt() {}
+
+ESPPreferenceObject ESPPreferences::make_preference(size_t, uint32_t, bool) { return {}; }
+ESPPreferenceObject ESPPreferences::make_preference(size_t, uint32_t) { return {}; }
+bool ESPPreferences::sync() { return true; }
+static ESPPreferences g_preferences;
+ESPPreferences *global_preferences = &g_preferences;
+
+namespace uart {
+int UARTDevice::available() { return static_cast<int>(g_rx.size()); }
+bool UARTDevice::read_byte(uint8_t *data) {
+  if (g_rx.empty()) return false;
+  *data = static_cast<uint8_t>(g_rx.front());
+  g_rx.erase(0, 1);
+  return true;
+}
+void UARTDevice::write_str(const char *str) { g_tx.append(str); }
+void UARTDevice::write_byte(uint8_t data) { g_tx.push_back(static_cast<char>(data)); }
+void UARTDevice::write_array(const uint8_t *data, size_t len) {
+  g_tx.append(reinterpret_cast<const char *>(data), len);
+}
+} // namespace uart
+
+namespace api {
+void APIServer::subscribe_home_assistant_state(std::string entity_id,
+    optional<std::string> attribute, std::function<void(std::string)> f) {
+  g_subscriptions.push_back({std::move(entity_id),
+    attribute.has_value() ? attribute.value() : std::string(), std::move(f)});
+}
+void APIServer::get_home_assistant_state(std::string entity_id,
+    optional<std::string> attribute, std::function<void(std::string)> f) {}
+void APIServer::send_homeassistant_service_call(const HomeassistantServiceResponse &call) {
+  g_service_calls.push_back(call);
+}
+static APIServer g_api_server;
+APIServer *global_api_server = &g_api_server;
+} // namespace api
+
+namespace nspanel_lovelace {
+// normally generated from the translation file selected in the yaml config
+FrozenCharMap<const char *, TRANSLATION_MAP_SIZE> TRANSLATION_MAP{{
+  {"eco", "Eco"},
+  {"position", "Position"},
+  {"speed", "Speed"},
+}};
+} // namespace nspanel_lovelace
+
+} // namespace esphome
+
+// ---- entity attribute reads ----
+
+// Entity::get_attribute() and Entity::has_attribute(), run.sh links with
+// --wrap for both so other objects call these instead. The member
+// functions are declared with their mangled names, `this` is the first
+// argument in the Itanium C++ ABI.
+using esphome::nspanel_lovelace::Entity;
+using esphome::nspanel_lovelace::ha_attr_type;
+
+extern "C" {
+const std::string &__real__ZNK7esphome16nspanel_lovelace6Entity13get_attributeENS0_12ha_attr_typeERKNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEE(
+    const Entity *entity, ha_attr_type attr, const std::string &default_value);
+bool __real__ZNK7esphome16nspanel_lovelace6Entity13has_attributeENS0_12ha_attr_typeE(
+    const Entity *entity, ha_attr_type attr);
+
+const std::string &__wrap__ZNK7esphome16nspanel_lovelace6Entity13get_attributeENS0_12ha_attr_typeERKNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEE(
+    const Entity *entity, ha_attr_type attr, const std::string &default_value) {
+  if (g_track_reads) g_attribute_reads[entity] |= esphome::nspanel_lovelace::to_mask(attr);
+  return __real__ZNK7esphome16nspanel_lovelace6Entity13get_attributeENS0_12ha_attr_typeERKNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEE(
+    entity, attr, default_value);
+}
+bool __wrap__ZNK7esphome16nspanel_lovelace6Entity13has_attributeENS0_12ha_attr_typeE(
+    const Entity *entity, ha_attr_type attr) {
+  if (g_track_reads) g_attribute_reads[entity] |= esphome::nspanel_lovelace::to_mask(attr);
+  return __real__ZNK7esphome16nspanel_lovelace6Entity13has_attributeENS0_12ha_attr_typeE(
+    entity, attr);
+}
+} // extern "C"
+
+// ---- harness ----
+
+namespace nspanel_test {
+
+uint32_t now_ms() { return g_now; }
+
+void advance_ms(uint32_t ms) {
+  const uint32_t target = g_now + ms;
+  while (true) {
+    auto next = std::min_element(g_scheduled.begin(), g_scheduled.end(),
+      [](const scheduled &a, const scheduled &b) { return a.due < b.due; });
+    if (next == g_scheduled.end() || next->due > target) break;
+    g_now = next->due;
+    // the callback may schedule or cancel, so run a copy
+    auto fn = next->fn;
+    if (next->interval == 0) {
+      g_scheduled.erase(next);
+    } else {
+      next->due += next->interval;
+    }
+    fn();
+  }
+  g_now = target;
+}
+
+std::string &uart_tx() { return g_tx; }
+
+std::vector<std::string> uart_tx_frames() {
+  // 0x55 0xBB {length, little endian} {payload} {crc16}
+  std::vector<std::string> frames;
+  size_t pos = 0;
+  while (pos + 4 <= g_tx.size()) {
+    size_t length = static_cast<uint8_t>(g_tx[pos + 2]) |
+      (static_cast<uint8_t>(g_tx[pos + 3]) << 8);
+    if (pos + 4 + length + 2 > g_tx.size()) break;
+    frames.push_back(g_tx.substr(pos + 4, length));
+    pos += 4 + length + 2;
+  }
+  return frames;
+}
+
+void uart_tx_clear() { g_tx.clear(); }
+
+void uart_rx_event(const std::string &message) {
+  std::string frame;
+  frame.push_back(static_cast<char>(0x55));
+  frame.push_back(static_cast<char>(0xBB));
+  frame.push_back(static_cast<char>(message.size() & 0xFF));
+  frame.push_back(static_cast<char>((message.size() >> 8) & 0xFF));
+  frame.append(message);
+  uint16_t crc = esphome::crc16(
+    reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+  frame.push_back(static_cast<char>(crc & 0xFF));
+  frame.push_back(static_cast<char>((crc >> 8) & 0xFF));
+  g_rx.append(frame);
+}
+
+size_t ha_send(const std::string &entity_id, const std::string &attribute,
+    const std::string &value) {
+  size_t count = 0;
+  for (auto &sub : g_subscriptions) {
+    if (sub.entity_id != entity_id || sub.attribute != attribute) continue;
+    sub.fn(value);
+    count++;
+  }
+  return count;
+}
+
+size_t ha_subscription_count() { return g_subscriptions.size(); }
+
+std::vector<std::pair<std::string, std::string>> ha_subscriptions() {
+  std::vector<std::pair<std::string, std::string>> subscriptions;
+  for (auto &sub : g_subscriptions) {
+    subscriptions.emplace_back(sub.entity_id, sub.attribute);
+  }
+  return subscriptions;
+}
+
+void track_attribute_reads(bool enabled) { g_track_reads = enabled; }
+std::map<const Entity *, esphome::nspanel_lovelace::ha_attr_mask> &attribute_reads() {
+  return g_attribute_reads;
+}
+
+std::vector<esphome::api::HomeassistantServiceResponse> &ha_service_calls() {
+  return g_service_calls;
+}
+
+void log_capture(bool enabled) { g_log_capture = enabled; }
+std::vector<std::string> &log_lines() { return g_log_lines; }
+
+size_t alloc_count() { return g_alloc_count; }
+size_t alloc_bytes() { return g_alloc_bytes; }
+
+int check_failures() { return g_check_failures; }
+
+void check_(bool ok, const char *expr, const char *file, int line) {
+  if (ok) return;
+  g_check_failures++;
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+}
+
+int finish() {
+  if (g_check_failures > 0) {
+    fprintf(stderr, "%d check(s) failed\n", g_check_failures);
+    return 1;
+  }
+  return 0;
+}
+
+bench_result bench(const char *name, const std::function<size_t()> &fn,
+    uint32_t min_ms) {
+  using clock = std::chrono::steady_clock;
+  // warm up caches and lazily sized buffers
+  fn();
+  size_t iterations = 0, bytes = 0;
+  const size_t allocs_before = g_alloc_count;
+  const auto started = clock::now();
+  auto elapsed = clock::duration::zero();
+  do {
+    // batches keep the clock reads out of the measurement
+    for (int i = 0; i < 64; i++) bytes += fn();
+    iterations += 64;
+    elapsed = clock::now() - started;
+  } while (elapsed < std::chrono::milliseconds(min_ms));
+
+  bench_result result{
+    std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+    static_cast<double>(g_alloc_count - allocs_before) / iterations,
+    static_cast<double>(bytes) / iterations,
+  };
+  printf("{\"bench\":\"%s\",\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,"
+      "\"bytes_per_op\":%.1f,\"iterations\":%zu}\n",
+      name, result.ns_per_op, result.allocs_per_op, result.bytes_per_op,
+      iterations);
+  return result;
+}
+
+TestPanel::TestPanel() { this->set_uart_parent(&this->uart_); }
+
+TestPanel::~TestPanel() {
+  // the callbacks point at this panel
+  g_scheduled.clear();
+  g_subscriptions.clear();
+  g_service_calls.clear();
+  g_attribute_reads.clear();
+  g_track_reads = false;
+  g_rx.clear();
+  g_tx.clear();
+}
+
+void TestPanel::drain(uint32_t step_ms) {
+  for (int i = 0; i < 1000; i++) {
+    this->loop();
+    if (this->command_queue_.empty() && this->command_buffer_.empty()) return;
+    advance_ms(step_ms);
+  }
+}
+
+} // namespace nspanel_test
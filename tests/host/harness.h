@@ -0,0 +1,131 @@
+#pragma once
+
+// Host test harness for the nspanel_lovelace component.
+// The component is built against the ESPHome stubs in stubs/, this header
+// gives tests control over the fake clock, UART, Home Assistant API and
+// counts heap allocations. See run.sh for how everything is built.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nspanel_lovelace.h"
+
+namespace nspanel_test {
+
+// ---- clock and scheduler ----
+
+uint32_t now_ms();
+// Moves the fake clock forward, running any timeouts and intervals which
+// become due on the way
+void advance_ms(uint32_t ms);
+
+// ---- UART ----
+
+// Everything the component wrote to the display
+std::string &uart_tx();
+// Payloads of the frames written to the display
+std::vector<std::string> uart_tx_frames();
+void uart_tx_clear();
+// Queues a display event (e.g. "event,buttonPress2,...") as a framed message
+void uart_rx_event(const std::string &message);
+
+// ---- Home Assistant API ----
+
+// Sends a state (attribute empty) or attribute update to all subscribers
+// of entity_id, returns the number of subscriptions updated
+size_t ha_send(const std::string &entity_id, const std::string &attribute,
+    const std::string &value);
+size_t ha_subscription_count();
+// {entity_id, attribute} of every subscription, the attribute is empty for
+// state subscriptions
+std::vector<std::pair<std::string, std::string>> ha_subscriptions();
+// The service calls the component has sent
+std::vector<esphome::api::HomeassistantServiceResponse> &ha_service_calls();
+
+// ---- logging ----
+
+// While enabled every log line is kept, e.g. to read dump_config() output.
+// Set NSPANEL_TEST_LOG=1 to also print them.
+void log_capture(bool enabled);
+std::vector<std::string> &log_lines();
+
+// ---- entity attribute reads ----
+
+// While enabled every Entity::get_attribute() and has_attribute() call made
+// outside entity.cpp is recorded per entity. run.sh wraps both functions at
+// link time, so this needs g++/libstdc++ symbol names.
+void track_attribute_reads(bool enabled);
+std::map<const esphome::nspanel_lovelace::Entity *,
+    esphome::nspanel_lovelace::ha_attr_mask> &attribute_reads();
+
+// ---- heap allocation accounting ----
+
+// Number of operator new calls since the program started
+size_t alloc_count();
+size_t alloc_bytes();
+
+// ---- checks ----
+
+int check_failures();
+#define CHECK(cond) \
+  ::nspanel_test::check_((cond), #cond, __FILE__, __LINE__)
+void check_(bool ok, const char *expr, const char *file, int line);
+// Returns the exit code for main()
+int finish();
+
+// ---- benchmarks ----
+
+struct bench_result {
+  double ns_per_op;
+  double allocs_per_op;
+  double bytes_per_op;
+};
+
+// Runs fn until at least min_ms of wall time has passed and prints one JSON
+// line: {"bench":name,"ns_per_op":..,"allocs_per_op":..,"bytes_per_op":..}
+// bytes is whatever fn returns, e.g. the length of the rendered output.
+bench_result bench(const char *name, const std::function<size_t()> &fn,
+    uint32_t min_ms = 200);
+
+// Gives protected members of the panel to tests. The fakes are shared,
+// so only one panel may exist at a time, its destructor resets them.
+class TestPanel : public esphome::nspanel_lovelace::NSPanelLovelace {
+public:
+  TestPanel();
+  ~TestPanel();
+
+  using NSPanelLovelace::command_buffer_;
+  using NSPanelLovelace::command_queue_;
+  using NSPanelLovelace::current_page_;
+  using NSPanelLovelace::current_page_index_;
+  using NSPanelLovelace::dirty_entities_;
+  using NSPanelLovelace::entities_;
+  using NSPanelLovelace::optimistic_confirmed_count_;
+  using NSPanelLovelace::optimistic_corrected_count_;
+  using NSPanelLovelace::optimistic_pending_;
+  using NSPanelLovelace::pages_;
+  using NSPanelLovelace::prerender_count_;
+  using NSPanelLovelace::render_climate_detail_update_;
+  using NSPanelLovelace::render_cover_detail_update_;
+  using NSPanelLovelace::render_fan_detail_update_;
+  using NSPanelLovelace::render_input_select_detail_update_;
+  using NSPanelLovelace::render_page_;
+  using NSPanelLovelace::render_light_detail_update_;
+  using NSPanelLovelace::render_timer_detail_update_;
+  using NSPanelLovelace::screensaver_;
+
+  // Runs loop() until the display command queue is empty
+  void drain(uint32_t step_ms = 10);
+
+protected:
+  esphome::uart::UARTComponent uart_;
+};
+
+} // namespace nspanel_test
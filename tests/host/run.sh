@@ -0,0 +1,60 @@
+#!/bin/bash
+# Builds the nspanel_lovelace component for the host against the ESPHome
+# stubs in stubs/ and runs the test_*.cpp and bench_*.cpp programs here.
+#
+#   tests/host/run.sh                  build and run everything
+#   tests/host/run.sh test_prerender   build and run the named programs
+#
+# Tests exit non-zero when a check fails. Benchmarks print one JSON object
+# per line so results can be saved and compared between versions, e.g.
+#   tests/host/run.sh bench_render > before.jsonl
+set -euo pipefail
+
+HOST_DIR="$(cd "$(dirname "$0")" && pwd)"
+COMPONENT_DIR="$HOST_DIR/../../components/nspanel_lovelace"
+BUILD_DIR="${BUILD_DIR:-$HOST_DIR/build}"
+CXX="${CXX:-g++}"
+CXXFLAGS=(-std=gnu++17 -O2 -g -Wall
+  -DUSE_ESP_IDF -DUSE_TIME -DUSE_NSPANEL_TFT_UPLOAD -DUSE_NSPANEL_RENDER_STATS
+  -DTRANSLATION_MAP_SIZE=3 -DCUSTOM_ICONS_SIZE=0
+  -isystem "$HOST_DIR/stubs" -I"$HOST_DIR" -I"$COMPONENT_DIR")
+
+# Entity::get_attribute() and has_attribute() go through the harness so it
+# can record which attributes are read (g++/libstdc++ symbol names)
+LDFLAGS=(
+  -Wl,--wrap=_ZNK7esphome16nspanel_lovelace6Entity13get_attributeENS0_12ha_attr_typeERKNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEE
+  -Wl,--wrap=_ZNK7esphome16nspanel_lovelace6Entity13has_attributeENS0_12ha_attr_typeE)
+
+mkdir -p "$BUILD_DIR"
+
+objects=()
+for src in "$COMPONENT_DIR"/*.cpp "$HOST_DIR/harness.cpp"; do
+  case "$(basename "$src")" in nspanel_lovelace_upload_*) continue;; esac
+  obj="$BUILD_DIR/$(basename "${src%.cpp}").o"
+  if [ ! -f "$obj" ] || [ "$src" -nt "$obj" ] ||
+      [ -n "$(find "$COMPONENT_DIR" "$HOST_DIR" -name '*.h' -newer "$obj" -print -quit)" ]; then
+    "$CXX" "${CXXFLAGS[@]}" -c "$src" -o "$obj"
+  fi
+  objects+=("$obj")
+done
+
+if [ $# -gt 0 ]; then
+  programs=("$@")
+else
+  programs=()
+  for src in "$HOST_DIR"/test_*.cpp "$HOST_DIR"/bench_*.cpp; do
+    [ -f "$src" ] && programs+=("$(basename "${src%.cpp}")")
+  done
+fi
+
+failed=0
+for program in "${programs[@]}"; do
+  program="${program%.cpp}"
+  "$CXX" "${CXXFLAGS[@]}" "$HOST_DIR/$program.cpp" "${objects[@]}" "${LDFLAGS[@]}" -o "$BUILD_DIR/$program"
+  echo "== $program" >&2
+  if ! "$BUILD_DIR/$program"; then
+    echo "FAILED: $program" >&2
+    failed=1
+  fi
+done
+exit $failed
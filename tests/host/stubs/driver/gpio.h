@@ -0,0 +1,6 @@
+#pragma once
+#include <cstdint>
+enum gpio_num_t { GPIO_NUM_4 = 4 };
+inline int gpio_set_level(gpio_num_t, uint32_t){return 0;}
+inline void vTaskDelay(uint32_t){}
+#define pdMS_TO_TICKS(x) (x)
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#define MALLOC_CAP_SPIRAM (1<<10)
+#define MALLOC_CAP_INTERNAL (1<<11)
+#define MALLOC_CAP_8BIT (1<<2)
+#define MALLOC_CAP_DEFAULT (1<<12)
+inline size_t heap_caps_get_total_size(unsigned){return 0;}
+inline size_t heap_caps_get_free_size(unsigned){return 0;}
+inline size_t heap_caps_get_minimum_free_size(unsigned){return 0;}
+inline size_t heap_caps_get_largest_free_block(unsigned){return 0;}
+inline void* heap_caps_malloc(size_t s, unsigned){return malloc(s);}
+inline void heap_caps_free(void*p){free(p);}
+inline void* heap_caps_realloc(void*p,size_t s,unsigned){return realloc(p,s);}
@@ -0,0 +1,2 @@
+#pragma once
+typedef void* esp_http_client_handle_t;
@@ -0,0 +1,36 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "esphome/core/optional.h"
+namespace esphome { namespace api {
+struct HomeassistantServiceMap { std::string key; std::string value; };
+struct HomeassistantServiceResponse {
+  std::string service;
+  std::vector<HomeassistantServiceMap> data;
+  std::vector<HomeassistantServiceMap> data_template;
+  std::vector<HomeassistantServiceMap> variables;
+  bool is_event{false};
+};
+// subscriptions and service calls are recorded by the harness
+class APIServer {
+ public:
+  void subscribe_home_assistant_state(std::string entity_id, optional<std::string> attribute, std::function<void(std::string)> f);
+  void get_home_assistant_state(std::string entity_id, optional<std::string> attribute, std::function<void(std::string)> f);
+  void send_homeassistant_service_call(const HomeassistantServiceResponse &call);
+};
+extern APIServer *global_api_server;
+class CustomAPIDevice {
+ public:
+  template<typename T> void subscribe_homeassistant_state(void (T::*callback)(std::string), const std::string &entity_id, const std::string &attribute = "") {
+    auto f = std::bind(callback, (T *) this, std::placeholders::_1);
+    global_api_server->subscribe_home_assistant_state(entity_id,
+        attribute.empty() ? optional<std::string>() : optional<std::string>(attribute), f);
+  }
+  template<typename T> void subscribe_homeassistant_state(void (T::*callback)(std::string, std::string), const std::string &entity_id, const std::string &attribute = "") {
+    auto f = std::bind(callback, (T *) this, entity_id, std::placeholders::_1);
+    global_api_server->subscribe_home_assistant_state(entity_id,
+        attribute.empty() ? optional<std::string>() : optional<std::string>(attribute), f);
+  }
+};
+}}
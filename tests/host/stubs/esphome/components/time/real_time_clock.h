@@ -0,0 +1,6 @@
+#pragma once
+#include <functional>
+#include "esphome/core/time.h"
+namespace esphome { namespace time {
+class RealTimeClock { public: ESPTime now(); void add_on_time_sync_callback(std::function<void()> &&cb); };
+}}
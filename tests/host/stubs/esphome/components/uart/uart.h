@@ -0,0 +1,29 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+namespace esphome { namespace uart {
+class UARTComponent {
+ public:
+  uint32_t get_baud_rate() const { return baud_rate_; }
+  void set_baud_rate(uint32_t baud_rate) { baud_rate_ = baud_rate; }
+  virtual void setup() {}
+ protected:
+  uint32_t baud_rate_{115200};
+};
+// reads from and writes to the buffers in harness.h
+class UARTDevice {
+ public:
+  void set_uart_parent(UARTComponent *parent) { parent_ = parent; }
+  int available();
+  bool read_byte(uint8_t *data);
+  void write_str(const char *str);
+  void write_byte(uint8_t data);
+  void write_array(const uint8_t *data, size_t len);
+  void write_array(const std::vector<uint8_t> &data) { write_array(data.data(), data.size()); }
+  template<size_t N> void write_array(const std::array<uint8_t, N> &data) { write_array(data.data(), N); }
+ protected:
+  UARTComponent *parent_{nullptr};
+};
+}}
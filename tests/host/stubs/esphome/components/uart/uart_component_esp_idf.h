@@ -0,0 +1,3 @@
+#pragma once
+#include "uart.h"
+namespace esphome { namespace uart { class IDFUARTComponent : public UARTComponent {}; }}
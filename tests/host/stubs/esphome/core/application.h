@@ -0,0 +1,5 @@
+#pragma once
+namespace esphome {
+class Application { public: void feed_wdt(); };
+extern Application App;
+}
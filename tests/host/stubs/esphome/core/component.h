@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/optional.h"
+#include "esphome/core/helpers.h"
+namespace esphome {
+namespace setup_priority { extern const float DATA; }
+class Component {
+ public:
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0; }
+  uint32_t get_object_id_hash();
+ protected:
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);
+  void set_interval(uint32_t interval, std::function<void()> &&f);
+  bool cancel_interval(const std::string &name);
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f);
+  void set_timeout(uint32_t timeout, std::function<void()> &&f);
+  bool cancel_timeout(const std::string &name);
+  void defer(std::function<void()> &&f);
+};
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "esphome/core/optional.h"
+namespace esphome {
+std::string to_string(int value);
+std::string to_string(long value);
+std::string to_string(long long value);
+std::string to_string(unsigned value);
+std::string to_string(unsigned long value);
+std::string to_string(unsigned long long value);
+std::string to_string(float value);
+std::string to_string(double value);
+std::string str_snprintf(const char *fmt, size_t len, ...);
+bool str_startswith(const std::string &str, const std::string &start);
+bool str_endswith(const std::string &str, const std::string &end);
+std::string format_hex(const std::vector<uint8_t> &data);
+constexpr uint16_t encode_uint16(uint8_t msb, uint8_t lsb) { return (uint16_t(msb) << 8) | uint16_t(lsb); }
+uint16_t crc16(const uint8_t *data, uint16_t len, uint16_t crc = 0xffff, uint16_t reverse_poly = 0xa001, bool refin = false, bool refout = false);
+uint32_t fnv1_hash(const std::string &str);
+template<typename... X> class CallbackManager;
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) { for (auto &cb : callbacks_) cb(args...); }
+  size_t size() const { return callbacks_.size(); }
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+}
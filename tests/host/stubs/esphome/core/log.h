@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdio>
+#include <cinttypes>
+namespace esphome {
+// printed when NSPANEL_TEST_LOG is set, see harness.cpp
+__attribute__((format(printf, 3, 4))) void esp_log_printf_(char level, const char *tag, const char *fmt, ...);
+}
+#define ESP_LOGE(tag, ...) ::esphome::esp_log_printf_('E', tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::esp_log_printf_('W', tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::esp_log_printf_('I', tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::esp_log_printf_('D', tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::esp_log_printf_('V', tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) ::esphome::esp_log_printf_('V', tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::esp_log_printf_('C', tag, __VA_ARGS__)
@@ -0,0 +1,19 @@
+#pragma once
+#include <utility>
+namespace esphome {
+struct nullopt_t { explicit constexpr nullopt_t(int) {} };
+constexpr nullopt_t nullopt{0};
+template<typename T> class optional {
+ public:
+  optional() {}
+  optional(nullopt_t) {}
+  optional(const T &v) : has_(true), v_(v) {}
+  bool has_value() const { return has_; }
+  T &value() { return v_; }
+  const T &value() const { return v_; }
+  explicit operator bool() const { return has_; }
+ private:
+  bool has_{false};
+  T v_{};
+};
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <ctime>
+#include <cstdint>
+#include <string>
+namespace esphome {
+struct ESPTime {
+  uint8_t second, minute, hour, day_of_week, day_of_month;
+  uint16_t day_of_year;
+  uint8_t month;
+  uint16_t year;
+  bool is_dst;
+  time_t timestamp;
+  std::string strftime(const std::string &format);
+  bool is_valid() const;
+  static ESPTime from_epoch_utc(time_t epoch);
+};
+}
@@ -0,0 +1,47 @@
+// command_writer formats every integer type as a number and only writes
+// characters through append_char(), see test_num_str.cpp for why
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "command_writer.h"
+#include "harness.h"
+
+using namespace nspanel_test;
+using namespace esphome::nspanel_lovelace;
+
+namespace {
+
+template<class T, class = void>
+struct can_append : std::false_type {};
+template<class T>
+struct can_append<T, decltype(std::declval<command_writer &>().append(
+    std::declval<T>()), void())> : std::true_type {};
+
+static_assert(can_append<uint8_t>::value, "uint8_t");
+static_assert(can_append<uint16_t>::value, "uint16_t");
+static_assert(can_append<int>::value, "int");
+static_assert(can_append<long>::value, "long");
+static_assert(can_append<unsigned long>::value, "unsigned long");
+// a char would otherwise silently become a number or a character
+static_assert(!can_append<char>::value, "char");
+
+} // namespace
+
+int main() {
+  std::string buffer;
+  uint8_t position = 60;
+  uint16_t speed_max = 4;
+  command_writer(buffer, "entityUpdateDetail")
+    .uuid("12")
+    .field(position).append_char('%')
+    .field(speed_max)
+    .field(-3L)
+    .bit(true)
+    .percent_or_disable(false, 0)
+    .field().list("a,b,c");
+  CHECK(buffer == "entityUpdateDetail~uuid.12~60%~4~-3~1~disable~a?b?c");
+  return finish();
+}
@@ -0,0 +1,24 @@
+// The icon colour text kept by PageItem_Icon follows every colour change
+
+#include "harness.h"
+#include "page_items.h"
+
+using namespace nspanel_test;
+using namespace esphome::nspanel_lovelace;
+
+int main() {
+  NavigationItem item("1", "grid", icon_t::home, 17299u);
+  CHECK(item.get_icon_color_str() == "17299");
+
+  item.set_icon_color(0u);
+  CHECK(item.get_icon_color_str() == "0");
+  item.set_icon_color(65535u);
+  CHECK(item.get_icon_color_str() == "65535");
+  // white in rgb565
+  item.set_icon_color({255, 255, 255});
+  CHECK(item.get_icon_color() == 65535u);
+  CHECK(item.get_icon_color_str() == "65535");
+
+  CHECK(item.render().find("~65535~") != std::string::npos);
+  return finish();
+}
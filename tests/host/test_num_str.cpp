@@ -0,0 +1,47 @@
+// num_str takes every integer type. On ESP-IDF 5 int32_t is long and
+// uint32_t is unsigned long, on the host long is 64 bit, either way
+// separate int32_t/uint32_t constructors would make these ambiguous.
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "harness.h"
+#include "helpers.h"
+
+using namespace nspanel_test;
+using namespace esphome::nspanel_lovelace;
+
+static_assert(std::is_constructible<num_str, uint8_t>::value, "uint8_t");
+static_assert(std::is_constructible<num_str, uint16_t>::value, "uint16_t");
+static_assert(std::is_constructible<num_str, int>::value, "int");
+static_assert(std::is_constructible<num_str, unsigned>::value, "unsigned");
+static_assert(std::is_constructible<num_str, long>::value, "long");
+static_assert(std::is_constructible<num_str, unsigned long>::value, "unsigned long");
+static_assert(std::is_constructible<num_str, int32_t>::value, "int32_t");
+static_assert(std::is_constructible<num_str, uint32_t>::value, "uint32_t");
+// characters and flags aren't numbers
+static_assert(!std::is_constructible<num_str, char>::value, "char");
+static_assert(!std::is_constructible<num_str, bool>::value, "bool");
+
+namespace {
+
+std::string str(const num_str &value) { return std::string(value); }
+
+} // namespace
+
+int main() {
+  CHECK(str(num_str(uint8_t{255})) == "255");
+  CHECK(str(num_str(uint16_t{65535})) == "65535");
+  CHECK(str(num_str(int16_t{-32768})) == "-32768");
+  CHECK(str(num_str(-1)) == "-1");
+  CHECK(str(num_str(42L)) == "42");
+  CHECK(str(num_str(4294967295UL)) == "4294967295");
+  CHECK(str(num_str(INT32_MIN)) == "-2147483648");
+
+  CHECK(str(num_str::fixed(uint16_t{215}, 1)) == "21.5");
+  CHECK(str(num_str::fixed(-5L, 2)) == "-0.05");
+  CHECK(str(num_str::fixed(21.25f, 1)) == "21.3");
+  CHECK(str(num_str::fixed(0.0, 2)) == "0.00");
+  return finish();
+}
@@ -0,0 +1,120 @@
+// Optimistic updates: a tapped control is shown with its expected value
+// straight away, Home Assistant's reply confirms or corrects it.
+
+#include <algorithm>
+#include <string>
+
+#include "fixtures.h"
+
+using namespace nspanel_test;
+
+namespace {
+
+constexpr uint32_t HA_ROUND_TRIP_MS = 300;
+
+bool sent(const std::string &text) {
+  for (auto &frame : uart_tx_frames()) {
+    if (frame.find(text) != std::string::npos) return true;
+  }
+  return false;
+}
+
+void show_entities_page(TestPanel &panel) {
+  panel.render_page_(3);
+  panel.drain();
+  uart_tx_clear();
+}
+
+// Taps the volume slider and answers after HA_ROUND_TRIP_MS, returns the
+// time until the new value was sent to the display
+uint32_t tap_to_display_ms(TestPanel &panel, const char *value) {
+  const uint32_t tapped = now_ms();
+  uart_rx_event(std::string("event,buttonPress2,uuid.31,number-set,") + value);
+  std::string shown = std::string("~") + value;
+  for (uint32_t elapsed = 0; elapsed < 2000; elapsed += 10) {
+    if (elapsed == HA_ROUND_TRIP_MS) {
+      ha_send("number.volume", "", std::string(value) + ".0");
+    }
+    panel.loop();
+    if (sent(shown)) return now_ms() - tapped;
+    advance_ms(10);
+  }
+  return UINT32_MAX;
+}
+
+void test_number_confirmed() {
+  TestPanel panel;
+  build_panel(panel);
+  start_panel(panel);
+  show_entities_page(panel);
+
+  // another entity changes just before the tap
+  ha_send("sensor.temperature", "", "22.8");
+  CHECK(panel.dirty_entities_.size() == 1);
+
+  uart_rx_event("event,buttonPress2,uuid.31,number-set,42");
+  panel.loop();
+  CHECK(panel.optimistic_pending_.size() == 1);
+  if (!panel.optimistic_pending_.empty()) {
+    CHECK(panel.optimistic_pending_[0].expected == "42.0");
+  }
+  // the tap doesn't flush the other entity ahead of its deadline
+  CHECK(panel.dirty_entities_.size() == 1);
+  panel.drain();
+  CHECK(sent("~42.0"));
+  CHECK(!sent("22.8"));
+
+  // Home Assistant reports numbers as floats
+  ha_send("number.volume", "", "42.0");
+  CHECK(panel.optimistic_pending_.empty());
+  CHECK(panel.optimistic_confirmed_count_ == 1);
+  CHECK(panel.optimistic_corrected_count_ == 0);
+
+  // a differently formatted but equal number confirms as well,
+  // taps within the control interval would be coalesced
+  advance_ms(1000);
+  uart_rx_event("event,buttonPress2,uuid.31,number-set,43");
+  panel.loop();
+  ha_send("number.volume", "", "43.00");
+  CHECK(panel.optimistic_confirmed_count_ == 2);
+  CHECK(panel.optimistic_corrected_count_ == 0);
+
+  // a different value is a correction
+  advance_ms(1000);
+  uart_rx_event("event,buttonPress2,uuid.31,number-set,44");
+  panel.loop();
+  ha_send("number.volume", "", "40.0");
+  CHECK(panel.optimistic_corrected_count_ == 1);
+  advance_ms(ENTITY_FLUSH_MAX_DELAY);
+  panel.drain();
+}
+
+uint32_t measure_latency(bool optimistic_updates) {
+  TestPanel panel;
+  panel.set_optimistic_updates(optimistic_updates);
+  build_panel(panel);
+  start_panel(panel);
+  show_entities_page(panel);
+  return tap_to_display_ms(panel, "60");
+}
+
+void test_latency() {
+  uint32_t with_optimistic = measure_latency(true);
+  uint32_t without_optimistic = measure_latency(false);
+
+  // the fake clock only advances in 10ms steps
+  printf("{\"bench\":\"tap_to_display_ms\",\"optimistic\":%u,\"confirmed\":%u,"
+      "\"ha_round_trip\":%u}\n", with_optimistic, without_optimistic,
+      HA_ROUND_TRIP_MS);
+  CHECK(with_optimistic < HA_ROUND_TRIP_MS);
+  CHECK(without_optimistic >= HA_ROUND_TRIP_MS);
+  CHECK(without_optimistic != UINT32_MAX);
+}
+
+} // namespace
+
+int main() {
+  test_number_confirmed();
+  test_latency();
+  return finish();
+}
@@ -0,0 +1,62 @@
+// Popup detail updates are rendered straight into the command buffer,
+// once the buffers have grown a repeated render must not allocate
+
+#include "fixtures.h"
+
+using namespace nspanel_test;
+
+namespace {
+
+size_t render_allocs(TestPanel &panel,
+    void (TestPanel::*render)(StatefulPageItem *), StatefulPageItem *item) {
+  const size_t before = alloc_count();
+  (panel.*render)(item);
+  const size_t allocs = alloc_count() - before;
+  panel.drain();
+  return allocs;
+}
+
+void check_popup(TestPanel &panel, const char *name,
+    void (TestPanel::*render)(StatefulPageItem *), StatefulPageItem *item) {
+  CHECK(item != nullptr);
+  if (item == nullptr) return;
+  uart_tx_clear();
+  render_allocs(panel, render, item);
+  CHECK(!uart_tx_frames().empty());
+  const size_t allocs = render_allocs(panel, render, item);
+  if (allocs != 0) {
+    fprintf(stderr, "popup/%s: %zu allocation(s) on the second render\n", name, allocs);
+  }
+  CHECK(allocs == 0);
+}
+
+} // namespace
+
+int main() {
+  TestPanel panel;
+  auto pages = build_panel(panel);
+  start_panel(panel);
+
+  auto grid_item = [&pages](size_t index) {
+    return pages.grid->get_item<StatefulPageItem>(index);
+  };
+  check_popup(panel, "light", &TestPanel::render_light_detail_update_, grid_item(0));
+  check_popup(panel, "cover", &TestPanel::render_cover_detail_update_, grid_item(2));
+  check_popup(panel, "fan", &TestPanel::render_fan_detail_update_, grid_item(3));
+  check_popup(panel, "input_select", &TestPanel::render_input_select_detail_update_, grid_item(4));
+  check_popup(panel, "timer", &TestPanel::render_timer_detail_update_, grid_item(5));
+  check_popup(panel, "climate", &TestPanel::render_climate_detail_update_,
+    pages.entities->get_item<StatefulPageItem>(2));
+
+  // a light without supported_color_modes has neither colour control
+  auto bare_light = pages.grid2->get_item<StatefulPageItem>(0);
+  uart_tx_clear();
+  panel.render_light_detail_update_(bare_light);
+  panel.drain();
+  auto frames = uart_tx_frames();
+  CHECK(frames.size() == 1);
+  if (frames.size() == 1) {
+    CHECK(frames[0].find("~disable~disable~") != std::string::npos);
+  }
+  return finish();
+}
@@ -0,0 +1,111 @@
+// Pages next to the current one are rendered while the panel is idle,
+// nothing of that may reach the display.
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "fixtures.h"
+
+using namespace nspanel_test;
+
+namespace {
+
+constexpr size_t SWIPES = 101;
+
+void test_prerender() {
+  TestPanel panel;
+  auto pages = build_panel(panel);
+  start_panel(panel);
+
+  // on the screensaver the neighbours are the first and last cards
+  for (auto &page : panel.pages_) page->release_render_cache();
+  const auto prerendered = panel.prerender_count_;
+  for (int i = 0; i < 10; i++) {
+    panel.loop();
+    CHECK(panel.command_buffer_.empty());
+    CHECK(panel.command_queue_.empty());
+    advance_ms(100);
+  }
+  CHECK(panel.prerender_count_ == prerendered + 2);
+  CHECK(pages.grid->has_render_cache());
+  CHECK(pages.alarm->has_render_cache());
+  CHECK(uart_tx().empty());
+
+  // opening the page sends the prerendered output, which has to match
+  // a full render
+  panel.render_next_page();
+  panel.drain();
+  auto frames = uart_tx_frames();
+  std::string expected;
+  pages.grid->set_render_invalid();
+  pages.grid->render(expected);
+  CHECK(frames.size() == 3);
+  if (frames.size() == 3) {
+    CHECK(frames[0] == "pageType~cardGrid");
+    CHECK(frames[1] == "timeout~10");
+    CHECK(frames[2] == expected);
+  }
+}
+
+// Swipes from the first grid card to the next one and returns the median
+// wall time from the tap until the first byte was written to the UART
+uint64_t swipe_to_first_byte_ns(bool prerendered) {
+  using clock = std::chrono::steady_clock;
+  TestPanel panel;
+  auto pages = build_panel(panel);
+  start_panel(panel);
+
+  std::vector<uint64_t> samples;
+  for (size_t i = 0; i < SWIPES; i++) {
+    panel.render_page_(1);
+    panel.drain();
+    uart_tx_clear();
+    if (prerendered) {
+      for (int j = 0; j < 4 && !pages.grid2->has_render_cache(); j++) {
+        panel.loop();
+        advance_ms(10);
+      }
+    } else {
+      for (auto &page : panel.pages_) page->release_render_cache();
+    }
+    CHECK(pages.grid2->has_render_cache() == prerendered);
+    // the first frame isn't held back by the command cooldown
+    advance_ms(COMMAND_COOLDOWN + 1);
+
+    const auto tapped = clock::now();
+    uart_rx_event("event,buttonPress2,navigate.uuid.grid2,button");
+    for (int j = 0; j < 100 && uart_tx().empty(); j++) {
+      panel.loop();
+      advance_ms(10);
+    }
+    samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now() - tapped).count());
+    CHECK(!uart_tx().empty());
+    CHECK(panel.current_page_ == pages.grid2);
+    panel.drain();
+  }
+  std::nth_element(samples.begin(), samples.begin() + SWIPES / 2, samples.end());
+  return samples[SWIPES / 2];
+}
+
+void test_latency() {
+  uint64_t cold = swipe_to_first_byte_ns(false);
+  uint64_t prerendered = swipe_to_first_byte_ns(true);
+
+  // wall time of the component code only, the fake clock doesn't move
+  // while a loop() runs
+  printf("{\"bench\":\"swipe_to_first_byte_ns\",\"cold\":%llu,"
+      "\"prerendered\":%llu,\"swipes\":%zu}\n",
+      static_cast<unsigned long long>(cold),
+      static_cast<unsigned long long>(prerendered), SWIPES);
+}
+
+} // namespace
+
+int main() {
+  test_prerender();
+  test_latency();
+  return finish();
+}
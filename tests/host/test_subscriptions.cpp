@@ -0,0 +1,112 @@
+// Subscriptions: every entity subscribes to exactly the attributes which
+// ENTITY_SUBSCRIPTIONS lists for its kind and usage, and no card or popup
+// reads an attribute that was never subscribed (it would never arrive).
+
+#include <string>
+
+#include "fixtures.h"
+
+using namespace nspanel_test;
+
+namespace {
+
+// weather.home state, temperature, temperature_unit and forecast are
+// subscribed by setup() rather than through an entity
+constexpr size_t WEATHER_SUBSCRIPTIONS = 4;
+
+ha_attr_mask subscribed_mask(const std::string &entity_id, size_t &count) {
+  ha_attr_mask mask = 0;
+  for (auto &sub : ha_subscriptions()) {
+    if (sub.first != entity_id) continue;
+    auto attr = sub.second.empty() ? ha_attr_type::state
+      : to_ha_attr(sub.second);
+    CHECK(attr != ha_attr_type::unknown);
+    // subscribed twice
+    CHECK((mask & to_mask(attr)) == 0);
+    mask |= to_mask(attr);
+    count++;
+  }
+  return mask;
+}
+
+std::string attr_names(ha_attr_mask mask) {
+  std::string names;
+  while (mask != 0) {
+    auto name = to_string(static_cast<ha_attr_type>(__builtin_ctzll(mask)));
+    if (!names.empty()) names.append(", ");
+    names.append(name == nullptr ? "?" : name);
+    mask &= mask - 1;
+  }
+  return names;
+}
+
+void show_page(TestPanel &panel, size_t index) {
+  panel.render_page_(index);
+  panel.drain();
+}
+
+bool open_popup(TestPanel &panel, const char *popup, const std::string &internal_id) {
+  uart_tx_clear();
+  uart_rx_event(std::string("event,pageOpenDetail,") + popup + "," + internal_id);
+  panel.drain();
+  for (auto &frame : uart_tx_frames()) {
+    if (frame.rfind("entityUpdateDetail", 0) == 0) return true;
+  }
+  return false;
+}
+
+} // namespace
+
+int main() {
+  TestPanel panel;
+  build_panel(panel);
+  start_panel(panel);
+
+  // subscriptions match the table
+  size_t entity_subscriptions = 0;
+  for (auto &entity : panel.entities_) {
+    ha_attr_mask expected = entity->get_extra_attributes() |
+      get_entity_subscriptions(ENTITY_SUBSCRIPTIONS, entity->get_type(), entity->get_usage());
+    ha_attr_mask subscribed = subscribed_mask(entity->get_entity_id(), entity_subscriptions);
+    if (subscribed != expected) {
+      printf("%s: subscribed [%s], expected [%s]\n",
+          entity->get_entity_id().c_str(), attr_names(subscribed).c_str(),
+          attr_names(expected).c_str());
+    }
+    CHECK(subscribed == expected);
+  }
+  CHECK(entity_subscriptions + WEATHER_SUBSCRIPTIONS == ha_subscription_count());
+
+  // every card and popup only reads subscribed attributes
+  track_attribute_reads(true);
+  for (size_t i = 0; i < panel.pages_.size(); i++) {
+    panel.pages_[i]->set_render_invalid();
+    show_page(panel, i);
+  }
+  show_page(panel, 1);
+  CHECK(open_popup(panel, "popupLight", "uuid.10"));
+  CHECK(open_popup(panel, "popupTimer", "uuid.15"));
+  CHECK(open_popup(panel, "popupShutter", "uuid.12"));
+  CHECK(open_popup(panel, "popupFan", "uuid.13"));
+  CHECK(open_popup(panel, "popupInSel", "uuid.14"));
+  show_page(panel, 3);
+  CHECK(open_popup(panel, "popupThermo", "uuid.32"));
+  show_page(panel, 4);
+  CHECK(open_popup(panel, "popupThermo", "climate.living"));
+  track_attribute_reads(false);
+
+  for (auto &entity : panel.entities_) {
+    auto reads = attribute_reads().find(entity.get());
+    if (reads == attribute_reads().end()) continue;
+    ha_attr_mask subscribed = entity->get_extra_attributes() |
+      get_entity_subscriptions(ENTITY_SUBSCRIPTIONS, entity->get_type(), entity->get_usage());
+    ha_attr_mask missing = reads->second & ~subscribed;
+    if (missing != 0) {
+      printf("%s: reads unsubscribed [%s]\n",
+          entity->get_entity_id().c_str(), attr_names(missing).c_str());
+    }
+    CHECK(missing == 0);
+  }
+
+  return finish();
+}
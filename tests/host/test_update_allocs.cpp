@@ -0,0 +1,50 @@
+// A Home Assistant value is moved from the subscription callback into the
+// Entity. The only allocation allowed is the string the API server builds
+// for the callback, here made by ha_send when it calls the subscriber.
+
+#include <string>
+
+#include "fixtures.h"
+
+using namespace nspanel_test;
+
+namespace {
+
+// longer than any small string buffer, so every copy would allocate
+const std::string LONG_TITLE(64, 't');
+const std::string LONG_STATE = "a state value longer than the small string buffer";
+
+// the ids are built up front, their own copies aren't part of the path
+size_t send_allocs(const std::string &entity_id, const std::string &attribute,
+    const std::string &value) {
+  const size_t before = alloc_count();
+  const size_t updated = ha_send(entity_id, attribute, value);
+  const size_t allocs = alloc_count() - before;
+  CHECK(updated == 1);
+  return allocs;
+}
+
+} // namespace
+
+int main() {
+  TestPanel panel;
+  auto pages = build_panel(panel);
+  start_panel(panel);
+  Entity *media = pages.media->get_media_entity();
+  Entity *sensor = pages.entities->get_item<StatefulPageItem>(0)->get_entity();
+
+  const std::string media_id("media_player.lounge"), media_title("media_title");
+  const std::string sensor_id("sensor.temperature"), state;
+  // the first update of each is a change, the second one isn't
+  for (int i = 0; i < 2; i++) {
+    CHECK(send_allocs(media_id, media_title, LONG_TITLE) <= 1);
+    CHECK(media->get_attribute(ha_attr_type::media_title) == LONG_TITLE);
+    CHECK(send_allocs(sensor_id, state, LONG_STATE) <= 1);
+    CHECK(sensor->get_state() == LONG_STATE);
+  }
+  CHECK(panel.dirty_entities_.size() == 2);
+
+  advance_ms(ENTITY_FLUSH_MAX_DELAY);
+  panel.drain();
+  return finish();
+}